@@ -241,7 +241,10 @@ private:
     void UpdatePollingRate()
     {
         auto rate = Device::PollingRate();
-        if (rate > 0)
+        auto stats = Device::ReportStats();
+        if (rate > 0 && stats.available)
+            SetStatusText(wxString::Format("%iHz, %lli lost, age %.0f/%ius%s", rate, (long long)stats.lostReports, stats.averageSampleAge, stats.maxSampleAge, Device::IsSaving() ? ", saving" : ""), 1);
+        else if (rate > 0)
             SetStatusText(wxString::Format("%iHz", rate), 1);
         else
             SetStatusText(wxEmptyString, 1);
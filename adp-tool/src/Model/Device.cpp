@@ -1,8 +1,10 @@
 #include "Adp.h"
 
+#include <cstddef>
 #include <memory>
 #include <algorithm>
 #include <map>
+#include <deque>
 #include <chrono>
 #include <thread>
 
@@ -10,6 +12,7 @@
 
 #include "Model/Device.h"
 #include "Model/Reporter.h"
+#include "Model/Protocol.h"
 #include "Model/Log.h"
 #include "Model/Utils.h"
 #include "Model/Firmware.h"
@@ -33,6 +36,26 @@ constexpr HidIdentifier HID_IDS[] =
 	{0x03eb, 0x204f},
 };
 
+// Sensor values have to move by more than this before the pad sends a new input report.
+constexpr int INPUT_REPORT_THRESHOLD = 1;
+
+// Interval at which the pad still sends input reports when nothing changes, in milliseconds.
+constexpr int INPUT_REPORT_IDLE_MS = 100;
+
+// Button events that have not been read are discarded, oldest first, beyond this number.
+constexpr size_t MAX_QUEUED_BUTTON_EVENTS = 1024;
+
+// Lights frames per second the pad is set to when streaming is available. The pad has no report to read
+// its frame rate back, so it is set on connect and tracked in PadState from then on.
+constexpr int LIGHTS_FRAME_RATE = 100;
+
+// The pad goes back to its light rules after a second without led frames,
+// so an unchanged streamed frame is repeated at this interval.
+constexpr milliseconds LED_FRAME_KEEPALIVE(500);
+
+// Debug reports read per call at most, which drains the debug buffer of the pad a few times over.
+constexpr int MAX_DEBUG_READS = 8;
+
 static_assert(sizeof(float) == sizeof(uint32_t), "32-bit float required");
 
 enum LedMappingFlags
@@ -119,6 +142,11 @@ static color24 ToColor24(RgbColor color)
 	return { color.red, color.green, color.blue };
 }
 
+static bool IsSameColor(const RgbColor& a, const RgbColor& b)
+{
+	return a.red == b.red && a.green == b.green && a.blue == b.blue;
+}
+
 SensorReport SensorState::ToReport(int index)
 {
 	SensorReport report;
@@ -128,6 +156,9 @@ SensorReport SensorState::ToReport(int index)
 	report.releaseThreshold = WriteU16LE(ToDeviceSensorValue(releaseThreshold));
 	report.resistorValue = resistorValue;
 	report.buttonMapping = button == 0 ? 0xFF : (button - 1);
+	report.flags = disabled ? SensorReport::ADC_DISABLED : 0;
+	report.sampling = (oversampling & SensorReport::OVERSAMPLING_MASK)
+		| ((rateDivisor << SensorReport::RATE_DIVISOR_SHIFT) & SensorReport::RATE_DIVISOR_MASK);
 
 	return report;
 }
@@ -178,10 +209,157 @@ static void PrintSensorReport(const SensorReport& r)
 	Log::Writef(L"  releaseThreshold: %i", ReadU16LE(r.releaseThreshold));
 	Log::Writef(L"  buttonMapping: %i", r.buttonMapping);
 	Log::Writef(L"  resistorValue: %i", r.resistorValue);
-	Log::Writef(L"  flags: %i", ReadU16LE(r.flags));
+	Log::Writef(L"  flags: %i", r.flags);
+	Log::Writef(L"  sampling: %i", r.sampling);
 	Log::Write(L"]");
 }
 
+// Reads the enabled light rules and led mappings, which have to be selected one at a time.
+static void ReadLightsConfiguration(Reporter& reporter, vector<LightRuleReport>& lightRules, vector<LedMappingReport>& ledMappings)
+{
+	SetPropertyReport selectReport;
+
+	LightRuleReport lightReport;
+	selectReport.propertyId = WriteU32LE(SetPropertyReport::SELECTED_LIGHT_RULE_INDEX);
+	for (int i = 0; i < MAX_LIGHT_RULES; ++i)
+	{
+		selectReport.propertyValue = WriteU32LE(i);
+		bool sendResult = reporter.Send(selectReport);
+
+		if (sendResult && reporter.Get(lightReport) && (lightReport.flags & LRF_ENABLED))
+		{
+			PrintLightRuleReport(lightReport);
+			lightRules.push_back(lightReport);
+		}
+	}
+
+	LedMappingReport ledReport;
+	selectReport.propertyId = WriteU32LE(SetPropertyReport::SELECTED_LED_MAPPING_INDEX);
+	for (int i = 0; i < MAX_LED_MAPPINGS; ++i)
+	{
+		selectReport.propertyValue = WriteU32LE(i);
+		bool sendResult = reporter.Send(selectReport);
+
+		if (sendResult && reporter.Get(ledReport) && (ledReport.flags & LMF_ENABLED))
+		{
+			PrintLedMappingReport(ledReport);
+			ledMappings.push_back(ledReport);
+		}
+	}
+}
+
+// Reads the configuration of every sensor, which have to be selected one at a time.
+static void ReadSensors(Reporter& reporter, int sensorCount, vector<SensorReport>& sensors)
+{
+	SensorReport sensorReport;
+	SetPropertyReport selectReport;
+	selectReport.propertyId = WriteU32LE(SetPropertyReport::SELECTED_SENSOR_INDEX);
+
+	for (int i = 0; i < sensorCount; ++i)
+	{
+		selectReport.propertyValue = WriteU32LE(i);
+		bool sendResult = reporter.Send(selectReport);
+
+		if (sendResult && reporter.Get(sensorReport))
+		{
+			PrintSensorReport(sensorReport);
+			sensors.push_back(sensorReport);
+		}
+	}
+}
+
+// Reads the sensors, light rules and led mappings from the config dump report, in a few transfers.
+// Returns false if the pad did not send it, in which case nothing was added.
+// The input report mode the pad starts in is -1 if it does not store one.
+static bool ReadConfigurationDump(
+	Reporter& reporter,
+	int sensorCount,
+	bool readLights,
+	vector<SensorReport>& sensors,
+	vector<LightRuleReport>& lightRules,
+	vector<LedMappingReport>& ledMappings,
+	int& inputReportMode)
+{
+	ConfigurationV2 dump;
+	int layoutVersion;
+	if (!reporter.Get(dump, layoutVersion))
+	{
+		return false;
+	}
+
+	auto& configuration = dump.v1;
+	inputReportMode = layoutVersion >= ConfigurationV2::LAYOUT_VERSION ? dump.inputReportMode : -1;
+
+	for (int i = 0; i < sensorCount && i < MAX_SENSOR_COUNT; ++i)
+	{
+		auto& sensor = configuration.sensors[i];
+		SensorReport report;
+		report.index = i;
+		report.threshold = sensor.threshold;
+		report.releaseThreshold = sensor.releaseThreshold;
+		report.buttonMapping = sensor.buttonMapping;
+		report.resistorValue = sensor.resistorValue;
+		report.flags = sensor.flags;
+		report.sampling = sensor.sampling;
+		PrintSensorReport(report);
+		sensors.push_back(report);
+	}
+
+	if (!readLights)
+	{
+		return true;
+	}
+
+	for (int i = 0; i < MAX_LIGHT_RULES; ++i)
+	{
+		auto& rule = configuration.lightRules[i];
+		if (rule.flags & LRF_ENABLED)
+		{
+			LightRuleReport report;
+			report.lightRuleIndex = i;
+			report.flags = rule.flags;
+			report.onColor = rule.onColor;
+			report.offColor = rule.offColor;
+			report.onFadeColor = rule.onFadeColor;
+			report.offFadeColor = rule.offFadeColor;
+			PrintLightRuleReport(report);
+			lightRules.push_back(report);
+		}
+	}
+
+	for (int i = 0; i < MAX_LED_MAPPINGS; ++i)
+	{
+		auto& mapping = configuration.ledMappings[i];
+		if (mapping.flags & LMF_ENABLED)
+		{
+			LedMappingReport report;
+			report.ledMappingIndex = i;
+			report.flags = mapping.flags;
+			report.lightRuleIndex = mapping.lightRuleIndex;
+			report.sensorIndex = mapping.sensorIndex;
+			report.ledIndexBegin = mapping.ledIndexBegin;
+			report.ledIndexEnd = mapping.ledIndexEnd;
+			PrintLedMappingReport(report);
+			ledMappings.push_back(report);
+		}
+	}
+
+	return true;
+}
+
+static const wchar_t* TraceEventName(int event)
+{
+	switch (event)
+	{
+	case DebugTraceRecord::DROPPED: return L"records dropped";
+	case DebugTraceRecord::CONFIG_STORED: return L"config stored";
+	case DebugTraceRecord::CONFIG_BANK_SELECTED: return L"config bank selected";
+	case DebugTraceRecord::INPUT_REPORT_MODE: return L"input report mode";
+	case DebugTraceRecord::LIGHTS_FRAME_SKIPPED: return L"lights frame skipped";
+	}
+	return L"unknown event";
+}
+
 // ====================================================================================================================
 // Pad device.
 // ====================================================================================================================
@@ -194,6 +372,13 @@ struct PollingData
 	int readsSinceLastUpdate = 0;
 	int pollingRate = 0;
 	time_point<system_clock> lastUpdate;
+
+	// Based on the input report trailer, which older firmware does not send.
+	int lastSequence = -1;
+	int64_t sampleAgeSinceLastUpdate = 0;
+	int sampleAgeMaxSinceLastUpdate = 0;
+	int trailersSinceLastUpdate = 0;
+	InputReportStats stats;
 };
 
 class PadDevice
@@ -206,10 +391,13 @@ public:
 		const IdentificationV2Report& identification,
 		const vector<LightRuleReport>& lightRules,
 		const vector<LedMappingReport>& ledMappings,
-		const vector<SensorReport>& sensors)
+		const vector<SensorReport>& sensors,
+		int inputReportMode)
 		: myReporter(move(reporter))
 		, myPath(path)
 	{
+		myPad.inputReportMode = inputReportMode;
+
 		UpdateName(name);
 		myPad.maxNameLength = MAX_NAME_LENGTH;
 
@@ -231,6 +419,55 @@ public:
 		myPad.featureDebug = (features & IdentificationV2Report::FEATURE_DEBUG) != 0;
 		myPad.featureDigipot = (features & IdentificationV2Report::FEATURE_DIGIPOT) != 0;
 		myPad.featureLights = (features & IdentificationV2Report::FEATURE_LIGHTS) != 0;
+		myPad.featureSensorExtremes = (features & IdentificationV2Report::FEATURE_SENSOR_EXTREMES) != 0;
+		myPad.featureLedFrames = (features & IdentificationV2Report::FEATURE_LED_FRAMES) != 0;
+		myPad.featureConfigDump = (features & IdentificationV2Report::FEATURE_CONFIG_DUMP) != 0;
+		myPad.featureConfigWrite = (features & IdentificationV2Report::FEATURE_CONFIG_WRITE) != 0;
+		myPad.featureDebugPendingFlag = (features & IdentificationV2Report::FEATURE_DEBUG_PENDING_FLAG) != 0;
+		myPad.featureDebugRecords = (features & IdentificationV2Report::FEATURE_DEBUG_RECORDS) != 0;
+		myPad.featureSensorSampling = (features & IdentificationV2Report::FEATURE_SENSOR_SAMPLING) != 0;
+		myPad.ledCount = identification.ledCount;
+
+		ConfigBanksReport banks;
+		if ((features & IdentificationV2Report::FEATURE_CONFIG_BANKS) && myReporter->Get(banks)) {
+			myPad.configBankCount = banks.bankCount;
+			myPad.activeConfigBank = banks.activeBank;
+		}
+
+		MemoryUsageReport memory;
+		if ((features & IdentificationV2Report::FEATURE_MEMORY_USAGE) && myReporter->Get(memory)) {
+			Log::Writef(L"Pad ram: %i bytes, %i static, %i free, stack used at most %i",
+				ReadU16LE(memory.ramSize), ReadU16LE(memory.staticSize),
+				ReadU16LE(memory.free), ReadU16LE(memory.stackHighWater));
+		}
+
+		// Only the wired sensors are sent when the compact input reports are used, which saves bus bandwidth.
+		// The extremes variant also carries peaks and troughs, so short spikes between reports are not lost.
+		// The mode is set back to the one the pad starts in on disconnect, see ~PadDevice.
+		if (myPad.featureSensorExtremes) {
+			myInputReportModeChanged = SetInputReportMode(SetPropertyReport::INPUT_REPORT_MODE_EXTREMES);
+		}
+		else if (features & IdentificationV2Report::FEATURE_COMPACT_INPUT_REPORT) {
+			myInputReportModeChanged = SetInputReportMode(SetPropertyReport::INPUT_REPORT_MODE_COMPACT);
+		}
+
+		// Only have the pad report changes, with a heartbeat so the polling rate stays visible while idle.
+		if (features & IdentificationV2Report::FEATURE_INPUT_REPORT_ON_CHANGE) {
+			SetProperty(SetPropertyReport::INPUT_REPORT_THRESHOLD, INPUT_REPORT_THRESHOLD);
+			SetProperty(SetPropertyReport::INPUT_REPORT_IDLE, INPUT_REPORT_IDLE_MS);
+		}
+
+		// Firmware since 1.4 only scans sensors that press a button or drive a light, the others read as zero.
+		// All sensors are scanned while the tool is connected, so they show up while they are being mapped.
+		// Scanning goes back to the used sensors on disconnect, see ~PadDevice.
+		if (myPad.firmwareVersion.IsNewer({ 1, 3 })) {
+			myScanAllSensors = SetProperty(SetPropertyReport::SCAN_ALL_SENSORS, 1);
+		}
+
+		// Streamed led frames are paced by the frame rate of the pad, which may have been changed before.
+		if (myPad.featureLedFrames) {
+			SetLightsFrameRate(LIGHTS_FRAME_RATE);
+		}
 
 		for (auto sensor : sensors)
 		{
@@ -250,7 +487,14 @@ public:
 
 	~PadDevice()
 	{
+		// Games may read the pad after the tool is gone, and only understand the mode the pad starts in.
+		if (myInputReportModeChanged) {
+			SetInputReportMode(max(myPad.inputReportMode, (int)SetPropertyReport::INPUT_REPORT_MODE_STANDARD));
+		}
 
+		if (myScanAllSensors) {
+			SetProperty(SetPropertyReport::SCAN_ALL_SENSORS, 0);
+		}
 	}
 
 	void UpdateName(const NameReport& report)
@@ -316,8 +560,12 @@ public:
 		SensorValuesReport report;
 
 		int aggregateValues[MAX_SENSOR_COUNT] = {};
+		int peakValues[MAX_SENSOR_COUNT] = {};
+		int troughValues[MAX_SENSOR_COUNT] = {};
+		bool extremesRead = false;
 		int pressedButtons = 0;
 		int inputsRead = 0;
+		bool buttonEventsPending = false;
 
 		for (int readsLeft = 100; readsLeft > 0; --readsLeft)
 		{
@@ -327,6 +575,22 @@ public:
 				pressedButtons |= ReadU16LE(report.buttonBits);
 				for (int i = 0; i < myPad.numSensors; ++i)
 					aggregateValues[i] += ReadU16LE(report.sensorValues[i]);
+				if (report.hasExtremes)
+				{
+					for (int i = 0; i < myPad.numSensors; ++i)
+					{
+						peakValues[i] = extremesRead ? max(peakValues[i], ReadU16LE(report.sensorPeaks[i])) : ReadU16LE(report.sensorPeaks[i]);
+						troughValues[i] = extremesRead ? min(troughValues[i], ReadU16LE(report.sensorTroughs[i])) : ReadU16LE(report.sensorTroughs[i]);
+					}
+					extremesRead = true;
+				}
+				if (report.hasTrailer)
+				{
+					UpdateReportTrailerStats(report.trailer);
+					buttonEventsPending |= (report.trailer.flags & InputReportTrailer::BUTTON_EVENTS_PENDING) != 0;
+					mySavePending = (report.trailer.flags & InputReportTrailer::SAVE_PENDING) != 0;
+					myDebugPending |= (report.trailer.flags & InputReportTrailer::DEBUG_PENDING) != 0;
+				}
 				++inputsRead;
 				break;
 
@@ -334,11 +598,19 @@ public:
 				readsLeft = 0;
 				break;
 
+			case ReadDataResult::IGNORED:
+				break;
+
 			case ReadDataResult::FAILURE:
 				return false;
 			}
 		}
 
+		// A failed read loses the events of that report, which is counted like events the pad dropped.
+		// The connection is kept, input reads fail as well when it is actually broken.
+		if (buttonEventsPending && !ReadButtonEventsReports())
+			myPollingData.stats.droppedButtonEvents++;
+
 		if (inputsRead > 0)
 		{
 			for (int i = 0; i < myPad.numSensors; ++i)
@@ -347,6 +619,8 @@ public:
 				auto value = (double)aggregateValues[i] / (double)inputsRead;
 				mySensors[i].pressed = button > 0 && IsBitSet(pressedButtons, button - 1);
 				mySensors[i].value = ToNormalizedSensorValue(value);
+				mySensors[i].peak = extremesRead ? ToNormalizedSensorValue(peakValues[i]) : mySensors[i].value;
+				mySensors[i].trough = extremesRead ? ToNormalizedSensorValue(troughValues[i]) : mySensors[i].value;
 			}
 			myPollingData.readsSinceLastUpdate += inputsRead;
 		}
@@ -358,6 +632,17 @@ public:
 			myPollingData.pollingRate = (int)lround(myPollingData.readsSinceLastUpdate / dt);
 			myPollingData.readsSinceLastUpdate = 0;
 			myPollingData.lastUpdate = now;
+
+			auto& stats = myPollingData.stats;
+			if (myPollingData.trailersSinceLastUpdate > 0)
+			{
+				stats.available = true;
+				stats.averageSampleAge = (double)myPollingData.sampleAgeSinceLastUpdate / myPollingData.trailersSinceLastUpdate;
+				stats.maxSampleAge = myPollingData.sampleAgeMaxSinceLastUpdate;
+			}
+			myPollingData.sampleAgeSinceLastUpdate = 0;
+			myPollingData.sampleAgeMaxSinceLastUpdate = 0;
+			myPollingData.trailersSinceLastUpdate = 0;
 		}
 
 		// Use the loop to save changes if needed
@@ -368,6 +653,73 @@ public:
 		return true;
 	}
 
+	void UpdateReportTrailerStats(const InputReportTrailer& trailer)
+	{
+		auto& stats = myPollingData.stats;
+
+		// The sequence number wraps at 256, so a gap of more than that many reports is undercounted.
+		if (myPollingData.lastSequence >= 0)
+		{
+			int missed = (trailer.sequence - myPollingData.lastSequence - 1) & 0xFF;
+			if (missed > 0)
+			{
+				stats.lostReports += missed;
+				stats.gaps++;
+				stats.largestGap = max(stats.largestGap, missed);
+			}
+		}
+		myPollingData.lastSequence = trailer.sequence;
+
+		int sampleAge = ReadU16LE(trailer.sampleAge);
+		myPollingData.sampleAgeSinceLastUpdate += sampleAge;
+		myPollingData.sampleAgeMaxSinceLastUpdate = max(myPollingData.sampleAgeMaxSinceLastUpdate, sampleAge);
+		myPollingData.trailersSinceLastUpdate++;
+	}
+
+	// Returns false if a read failed, the events read before it are kept.
+	bool ReadButtonEventsReports()
+	{
+		ButtonEventsReport report;
+		bool success = true;
+
+		// Keep reading while full reports come in, the queue on the pad holds a couple of them.
+		for (int readsLeft = 4; readsLeft > 0; --readsLeft)
+		{
+			if (!myReporter->Get(report))
+			{
+				success = false;
+				break;
+			}
+
+			myPollingData.stats.droppedButtonEvents += report.dropped;
+
+			int count = min((int)report.count, ButtonEventsReport::MAX_EVENTS);
+			for (int i = 0; i < count; ++i)
+			{
+				ButtonEvent event;
+				event.time = ReadU32LE(report.events[i].time);
+				event.button = report.events[i].button & ~ButtonEventsReport::BUTTON_PRESSED;
+				event.pressed = (report.events[i].button & ButtonEventsReport::BUTTON_PRESSED) != 0;
+				myButtonEvents.push_back(event);
+			}
+
+			if (count < ButtonEventsReport::MAX_EVENTS)
+				break;
+		}
+
+		while (myButtonEvents.size() > MAX_QUEUED_BUTTON_EVENTS)
+			myButtonEvents.pop_front();
+
+		return success;
+	}
+
+	vector<ButtonEvent> PopButtonEvents()
+	{
+		vector<ButtonEvent> result(myButtonEvents.begin(), myButtonEvents.end());
+		myButtonEvents.clear();
+		return result;
+	}
+
 	bool SetThreshold(int sensorIndex, double threshold)
 	{
 		mySensors[sensorIndex].threshold = threshold;
@@ -388,20 +740,129 @@ public:
 
 		// From v1.3 we have the SensorReport. Before that it's the PadConfiguration report
 		if (myPad.firmwareVersion.IsNewer({ 1, 2 })) {
+			BeginConfigWrite();
 			for (int i = 0; i < myPad.numSensors; ++i) {
 				mySensors[i].releaseThreshold = mySensors[i].threshold * myPad.releaseThreshold;
 				if (!SendSensor(i)) {
+					CommitConfigWrite();
 					return false;
 				}
 			}
 
-			return true;
+			return CommitConfigWrite();
 		}
 		else {
 			return SendPadConfiguration();
 		}
 	}
 
+	// Until the matching CommitConfigWrite, sensors, light rules and led mappings are collected instead of sent.
+	// Calls can be nested, only the outermost commit sends them.
+	void BeginConfigWrite()
+	{
+		++myConfigWriteDepth;
+	}
+
+	// Sends the collected writes in as few reports as possible. The pad applies the writes of a transaction at once,
+	// writes that do not fit in one transaction are split over several.
+	bool CommitConfigWrite()
+	{
+		if (myConfigWriteDepth == 0 || --myConfigWriteDepth > 0 || myConfigWrites.empty()) {
+			return true;
+		}
+
+		auto transactions = BatchConfigWrites(myConfigWrites);
+		myConfigWrites.clear();
+
+		for (auto& transaction : transactions)
+		{
+			bool success = SetProperty(SetPropertyReport::CONFIG_TRANSACTION, SetPropertyReport::CONFIG_TRANSACTION_BEGIN);
+			for (auto& report : transaction) {
+				success = success && myReporter->Send(report);
+			}
+
+			if (!success) {
+				SetProperty(SetPropertyReport::CONFIG_TRANSACTION, SetPropertyReport::CONFIG_TRANSACTION_ABORT);
+				return false;
+			}
+
+			if (!SetProperty(SetPropertyReport::CONFIG_TRANSACTION, SetPropertyReport::CONFIG_TRANSACTION_COMMIT)) {
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	// Drops the writes collected since the matching BeginConfigWrite, only the outermost abort drops them.
+	void AbortConfigWrite()
+	{
+		if (myConfigWriteDepth == 0 || --myConfigWriteDepth > 0) {
+			return;
+		}
+
+		myConfigWrites.clear();
+	}
+
+	// Collects a write of configuration bytes when a config write is open and the pad supports it.
+	bool QueueConfigWrite(int offset, const void* data, int size)
+	{
+		if (myConfigWriteDepth == 0 || !myPad.featureConfigWrite) {
+			return false;
+		}
+
+		auto bytes = (const uint8_t*)data;
+		myConfigWrites[offset].assign(bytes, bytes + size);
+		return true;
+	}
+
+	bool SetInputReportMode(int mode)
+	{
+		return SetProperty(SetPropertyReport::INPUT_REPORT_MODE, mode);
+	}
+
+	// Stores the input report mode the pad starts in, which the tool changes back to when it disconnects.
+	bool SetStartupInputReportMode(int mode)
+	{
+		if (myPad.inputReportMode < 0 || !myPad.featureConfigWrite) {
+			return false;
+		}
+
+		uint8_t value = (uint8_t)mode;
+		BeginConfigWrite();
+		QueueConfigWrite(offsetof(ConfigurationV2, inputReportMode), &value, sizeof(value));
+		if (!CommitConfigWrite()) {
+			return false;
+		}
+
+		myPad.inputReportMode = mode;
+		NotifyUnsavedChanges();
+		return true;
+	}
+
+	bool SetProperty(int propertyId, int value)
+	{
+		SetPropertyReport report;
+		report.propertyId = WriteU32LE(propertyId);
+		report.propertyValue = WriteU32LE(value);
+		return myReporter->Send(report);
+	}
+
+	// Firmware since 1.4 renders the lights from a frame clock.
+	bool SetLightsFrameRate(int framesPerSecond)
+	{
+		if (!myPad.featureLights || !myPad.firmwareVersion.IsNewer({ 1, 3 })) {
+			return false;
+		}
+
+		if (!SetProperty(SetPropertyReport::LIGHTS_FRAME_RATE, framesPerSecond)) {
+			return false;
+		}
+
+		myPad.lightsFrameRate = framesPerSecond;
+		return true;
+	}
+
 	bool SetAdcConfig(int sensorIndex, int resistorValue)
 	{
 		mySensors[sensorIndex].resistorValue = resistorValue;
@@ -409,6 +870,27 @@ public:
 		return SendSensor(sensorIndex);
 	}
 
+	bool SetOversampling(int sensorIndex, int oversampling)
+	{
+		mySensors[sensorIndex].oversampling = clamp(oversampling, 0, SensorReport::MAX_OVERSAMPLING_SHIFT);
+
+		return SendSensor(sensorIndex);
+	}
+
+	bool SetRateDivisor(int sensorIndex, int rateDivisor)
+	{
+		mySensors[sensorIndex].rateDivisor = clamp(rateDivisor, 0, SensorReport::MAX_RATE_DIVISOR_SHIFT);
+
+		return SendSensor(sensorIndex);
+	}
+
+	bool SetSensorDisabled(int sensorIndex, bool disabled)
+	{
+		mySensors[sensorIndex].disabled = disabled;
+
+		return SendSensor(sensorIndex);
+	}
+
 	void UpdateSensor(SensorReport sensor)
 	{
 		if (sensor.index < 0 || sensor.index > myPad.numSensors) {
@@ -418,6 +900,9 @@ public:
 		mySensors[sensor.index].threshold = ToNormalizedSensorValue(ReadU16LE(sensor.threshold));
 		mySensors[sensor.index].releaseThreshold = ToNormalizedSensorValue(ReadU16LE(sensor.releaseThreshold));
 		mySensors[sensor.index].resistorValue = sensor.resistorValue;
+		mySensors[sensor.index].oversampling = sensor.sampling & SensorReport::OVERSAMPLING_MASK;
+		mySensors[sensor.index].rateDivisor = (sensor.sampling & SensorReport::RATE_DIVISOR_MASK) >> SensorReport::RATE_DIVISOR_SHIFT;
+		mySensors[sensor.index].disabled = (sensor.flags & SensorReport::ADC_DISABLED) != 0;
 		mySensors[sensor.index].button = (sensor.buttonMapping >= myPad.numButtons ? 0 : (sensor.buttonMapping + 1));
 	}
 
@@ -425,7 +910,9 @@ public:
 	{
 		SensorReport report = mySensors[sensorIndex].ToReport(sensorIndex);
 
-		bool success = myReporter->Send(report);
+		int offset = offsetof(ConfigurationV1, sensors) + sensorIndex * sizeof(ConfigurationV1::Sensor);
+		bool success = QueueConfigWrite(offset, &report.threshold, sizeof(ConfigurationV1::Sensor))
+			|| myReporter->Send(report);
 
 		if (success) {
 			NotifyUnsavedChanges();
@@ -471,7 +958,8 @@ public:
 
 	bool SendLedMappingReport(const LedMappingReport& report)
 	{
-		if (!myReporter->Send(report))
+		int offset = offsetof(ConfigurationV1, ledMappings) + report.ledMappingIndex * sizeof(ConfigurationV1::LedMapping);
+		if (!QueueConfigWrite(offset, &report.flags, sizeof(ConfigurationV1::LedMapping)) && !myReporter->Send(report))
 			return false;
 
 		UpdateLedMapping(report);
@@ -509,7 +997,8 @@ public:
 
 	bool SendLightRuleReport(const LightRuleReport& report)
 	{
-		if (!myReporter->Send(report))
+		int offset = offsetof(ConfigurationV1, lightRules) + report.lightRuleIndex * sizeof(ConfigurationV1::LightRule);
+		if (!QueueConfigWrite(offset, &report.flags, sizeof(ConfigurationV1::LightRule)) && !myReporter->Send(report))
 			return false;
 
 		UpdateLightRule(report);
@@ -545,6 +1034,190 @@ public:
 		return SendLightRuleReport(report);
 	}
 
+	bool StreamLedFrame(const vector<RgbColor>& colors)
+	{
+		if (!myPad.featureLedFrames) {
+			return false;
+		}
+
+		myLedFrame.assign(colors.begin(), colors.end());
+		myLedFrame.resize(myPad.ledCount);
+		myLedFramePending = true;
+
+		return SendLedFrame();
+	}
+
+	// Sends the latest streamed frame, unless the previous one was sent less than a pad frame ago.
+	// In that case it is sent from a later update, and frames streamed in between are dropped.
+	bool SendLedFrame()
+	{
+		if (!myLedFramePending) {
+			return true;
+		}
+
+		// The pad does not render frames at all with a frame rate of zero.
+		if (myPad.lightsFrameRate <= 0) {
+			return true;
+		}
+
+		auto now = system_clock::now();
+		auto sinceLastFrame = now - myLastLedFrame;
+		if (sinceLastFrame < microseconds(1000000 / myPad.lightsFrameRate)) {
+			return true;
+		}
+
+		// The pad may have gone back to its light rules, so nothing is known about the frame it holds.
+		if (sinceLastFrame > LED_FRAME_KEEPALIVE) {
+			mySentLedFrame.clear();
+		}
+
+		bool synced = (mySentLedFrame.size() == myLedFrame.size());
+
+		// Send runs of changed leds, trimmed to the last changed led of each run.
+		vector<LedFrameReport> reports;
+		for (int i = 0; i < myPad.ledCount;)
+		{
+			if (synced && IsSameColor(myLedFrame[i], mySentLedFrame[i])) {
+				++i;
+				continue;
+			}
+
+			int count = min(LedFrameReport::MAX_LEDS, myPad.ledCount - i);
+			while (synced && count > 1 && IsSameColor(myLedFrame[i + count - 1], mySentLedFrame[i + count - 1])) {
+				--count;
+			}
+
+			LedFrameReport report;
+			report.flags = 0;
+			report.ledIndex = i;
+			report.ledCount = count;
+			for (int j = 0; j < count; ++j) {
+				report.colors[j] = ToColor24(myLedFrame[i + j]);
+			}
+			reports.push_back(report);
+
+			i += count;
+		}
+
+		myLedFramePending = false;
+
+		if (reports.empty())
+		{
+			// Identical to the frame the pad shows, only keep the stream alive.
+			if (sinceLastFrame < LED_FRAME_KEEPALIVE) {
+				return true;
+			}
+
+			LedFrameReport report;
+			report.ledIndex = 0;
+			report.ledCount = 0;
+			reports.push_back(report);
+		}
+
+		reports.back().flags = LedFrameReport::SHOW;
+
+		for (auto& report : reports)
+		{
+			if (!myReporter->Send(report)) {
+				mySentLedFrame.clear();
+				return false;
+			}
+		}
+
+		mySentLedFrame = myLedFrame;
+		myLastLedFrame = now;
+		return true;
+	}
+
+	bool SelectConfigBank(int bank)
+	{
+		if (bank < 0 || bank >= myPad.configBankCount) {
+			return false;
+		}
+
+		if (bank == myPad.activeConfigBank) {
+			return true;
+		}
+
+		// Changes that were not saved yet belong to the bank that is active now.
+		SaveChanges();
+
+		if (!SetProperty(SetPropertyReport::CONFIG_BANK, bank)) {
+			return false;
+		}
+
+		// The pad switches once the save above is written to eeprom, which takes up to a second or two.
+		// UpdateConfigBank picks up the switch.
+		myPendingConfigBank = bank;
+		myPendingConfigBankDeadline = steady_clock::now() + 3s;
+		return true;
+	}
+
+	// Reads the configuration of the bank requested by SelectConfigBank once the pad switched to it.
+	bool UpdateConfigBank()
+	{
+		if (myPendingConfigBank < 0) {
+			return true;
+		}
+
+		ConfigBanksReport banks;
+		if (!myReporter->Get(banks)) {
+			return false;
+		}
+
+		if (banks.activeBank != myPendingConfigBank) {
+			if (steady_clock::now() > myPendingConfigBankDeadline) {
+				Log::Writef(L"Pad did not switch to configuration bank %i", myPendingConfigBank);
+				myPendingConfigBank = -1;
+			}
+			return true;
+		}
+
+		myPad.activeConfigBank = myPendingConfigBank;
+		myPendingConfigBank = -1;
+		return ReloadConfiguration();
+	}
+
+	// Reads back the configuration after the pad replaced it, for example by switching banks.
+	bool ReloadConfiguration()
+	{
+		NameReport name;
+		if (!myReporter->Get(name)) {
+			return false;
+		}
+		UpdateName(name);
+
+		vector<SensorReport> sensors;
+		vector<LightRuleReport> lightRules;
+		vector<LedMappingReport> ledMappings;
+		bool dumped = myPad.featureConfigDump
+			&& ReadConfigurationDump(*myReporter, myPad.numSensors, myPad.featureLights, sensors, lightRules, ledMappings, myPad.inputReportMode);
+
+		if (!dumped) {
+			ReadSensors(*myReporter, myPad.numSensors, sensors);
+		}
+		for (auto& sensor : sensors) {
+			UpdateSensor(sensor);
+		}
+		if (!sensors.empty() && mySensors[0].threshold > 0) {
+			myPad.releaseThreshold = mySensors[0].releaseThreshold / mySensors[0].threshold;
+		}
+
+		if (myPad.featureLights)
+		{
+			if (!dumped) {
+				ReadLightsConfiguration(*myReporter, lightRules, ledMappings);
+			}
+
+			myLights.lightRules.clear();
+			myLights.ledMappings.clear();
+			UpdateLightsConfiguration(lightRules, ledMappings);
+		}
+
+		myChanges |= DCF_BUTTON_MAPPING | DCF_LIGHTS;
+		return true;
+	}
+
 	void Reset() { myReporter->SendReset(); }
 
 	void FactoryReset()
@@ -580,6 +1253,11 @@ public:
 		return myHasUnsavedChanges;
 	}
 
+	bool IsSaving() const
+	{
+		return mySavePending;
+	}
+
 	void SaveChanges()
 	{
 		if (myHasUnsavedChanges)
@@ -593,6 +1271,8 @@ public:
 
 	const int PollingRate() const { return myPollingData.pollingRate; }
 
+	const InputReportStats& ReportStats() const { return myPollingData.stats; }
+
 	const PadState& State() const { return myPad; }
 
 	const LightsState& Lights() const { return myLights; }
@@ -602,24 +1282,65 @@ public:
 		return (index >= 0 && index < myPad.numSensors) ? (mySensors + index) : nullptr;
 	}
 
+	// Reads the pending debug messages. Pads with the debug pending flag are only asked when they have any,
+	// other pads are asked on every call.
 	wstring ReadDebug()
 	{
-		if (!myPad.featureDebug) {
+		// Pads with debug records send trace records even when text messages are compiled out.
+		bool debugReport = myPad.featureDebug || myPad.featureDebugRecords;
+		if (!debugReport || (myPad.featureDebugPendingFlag && !myDebugPending)) {
 			return L"";
 		}
 
+		myDebugPending = false;
+
+		wstring messages;
 		DebugReport report;
-		if (!myReporter->Get(report)) {
-			return L"";
+		for (int readsLeft = MAX_DEBUG_READS; readsLeft > 0; --readsLeft)
+		{
+			if (!myReporter->Get(report)) {
+				break;
+			}
+
+			int messageSize = min(ReadU16LE(report.messageSize), (int)sizeof(report.messagePacket));
+			if (myPad.featureDebugRecords) {
+				myDebugRecords.insert(myDebugRecords.end(), report.messagePacket, report.messagePacket + messageSize);
+			}
+			else {
+				messages += widen(report.messagePacket, messageSize);
+			}
+
+			// A partly filled packet means the buffer on the pad is empty now.
+			if (messageSize < (int)sizeof(report.messagePacket)) {
+				break;
+			}
 		}
 
-		int messageSize = ReadU16LE(report.messageSize);
+		if (myPad.featureDebugRecords) {
+			messages = DecodeDebugRecords();
+		}
 
-		if (messageSize == 0) {
-			return L"";
+		return messages;
+	}
+
+	// Returns the text of the complete debug records read so far, and writes trace records to the log.
+	// The start of a record that is split over debug reports is kept until the rest arrives.
+	wstring DecodeDebugRecords()
+	{
+		auto decoded = adp::DecodeDebugRecords(myDebugRecords.data(), myDebugRecords.size());
+
+		for (auto& trace : decoded.traces) {
+			Log::Writef(L"Pad trace :: %ls (%i, %i) at %u us", TraceEventName(trace.event),
+				ReadU16LE(trace.args[0]), ReadU16LE(trace.args[1]), ReadU32LE(trace.time));
+		}
+
+		// The records can not be told apart anymore, so everything read was dropped.
+		if (decoded.unknownType >= 0) {
+			Log::Writef(L"ReadDebug :: unknown debug record type (%i)", decoded.unknownType);
 		}
 
-		return widen(report.messagePacket, messageSize);
+		myDebugRecords.erase(myDebugRecords.begin(), myDebugRecords.begin() + decoded.size);
+		return widen(decoded.text.data(), decoded.text.size());
 	}
 
 	DeviceChanges PopChanges()
@@ -642,8 +1363,50 @@ private:
 	SensorState mySensors[MAX_SENSOR_COUNT];
 	DeviceChanges myChanges = 0;
 	bool myHasUnsavedChanges = false;
+	bool mySavePending = false;
 	time_point<system_clock> myLastPendingChange;
 	PollingData myPollingData;
+	deque<ButtonEvent> myButtonEvents;
+	vector<RgbColor> myLedFrame;
+	vector<RgbColor> mySentLedFrame;
+	bool myLedFramePending = false;
+	time_point<system_clock> myLastLedFrame;
+	int myPendingConfigBank = -1; // Bank requested by SelectConfigBank that the pad did not switch to yet.
+	time_point<steady_clock> myPendingConfigBankDeadline;
+	bool myDebugPending = false;
+	vector<uint8_t> myDebugRecords; // Debug bytes read from the pad, which do not form a complete record yet.
+	int myConfigWriteDepth = 0;
+	map<int, vector<uint8_t>> myConfigWrites; // Collected configuration bytes by offset within ConfigurationV2.
+	bool myInputReportModeChanged = false;
+	bool myScanAllSensors = false;
+};
+
+// Keeps a config write open on the device while in scope, see PadDevice::BeginConfigWrite.
+// Leaving the scope without a commit, for example through an exception, drops the collected writes.
+// The tool already took over the values of those writes, so the configuration is read back from the pad.
+class ConfigWriteScope
+{
+public:
+	ConfigWriteScope(PadDevice* device) : myDevice(device) { if (myDevice) myDevice->BeginConfigWrite(); }
+
+	~ConfigWriteScope()
+	{
+		if (myDevice && !myCommitted) {
+			myDevice->AbortConfigWrite();
+			myDevice->ReloadConfiguration();
+		}
+	}
+
+	// Returns false if the pad did not apply the writes, see PadDevice::CommitConfigWrite.
+	bool Commit()
+	{
+		myCommitted = true;
+		return !myDevice || myDevice->CommitConfigWrite();
+	}
+
+private:
+	PadDevice* myDevice;
+	bool myCommitted = false;
 };
 
 // ====================================================================================================================
@@ -723,14 +1486,17 @@ public:
 		if (!compatible)
 			return false;
 
-		using namespace std::chrono_literals;
-		// Wait for any udev rules to run
-		std::this_thread::sleep_for(200ms);
-
 		// Open and configure HID for communicating with the pad.
+		// A device that just appeared may not be accessible until the udev rules ran, so only wait when opening fails.
 
 		auto hid = hid_open_path(deviceInfo->path);
 		if (!hid)
+		{
+			using namespace std::chrono_literals;
+			std::this_thread::sleep_for(200ms);
+			hid = hid_open_path(deviceInfo->path);
+		}
+		if (!hid)
 		{
 			Log::Writef(L"ConnectionManager :: hid_open failed (%ls) :: %hs", hid_error(nullptr), deviceInfo->path);
 
@@ -804,40 +1570,18 @@ public:
 			}
 		}
 
-		// If we got some lights, try to read the light rules.
+		// Newer firmware sends its whole configuration in a few pages, older firmware has every item selected and read.
 		vector<LightRuleReport> lightRules;
 		vector<LedMappingReport> ledMappings;
-		if (padIdentification.ledCount > 0 && padVersion.IsNewer({1, 1}))
-		{
-			SetPropertyReport selectReport;
+		int inputReportMode = -1;
+		bool readLights = padIdentification.ledCount > 0 && padVersion.IsNewer({1, 1});
+		bool dumped = (ReadU16LE(padIdentificationV2.features) & IdentificationV2Report::FEATURE_CONFIG_DUMP)
+			&& ReadConfigurationDump(*reporter, padIdentificationV2.sensorCount, readLights, sensors, lightRules, ledMappings, inputReportMode);
 
-			LightRuleReport lightReport;
-			selectReport.propertyId = WriteU32LE(SetPropertyReport::SELECTED_LIGHT_RULE_INDEX);
-			for (int i = 0; i < MAX_LIGHT_RULES; ++i)
-			{
-				selectReport.propertyValue = WriteU32LE(i);
-				bool sendResult = reporter->Send(selectReport);
-
-				if (sendResult && reporter->Get(lightReport) && (lightReport.flags & LRF_ENABLED))
-				{
-					PrintLightRuleReport(lightReport);
-					lightRules.push_back(lightReport);
-				}
-			}
-
-			LedMappingReport ledReport;
-			selectReport.propertyId = WriteU32LE(SetPropertyReport::SELECTED_LED_MAPPING_INDEX);
-			for (int i = 0; i < MAX_LED_MAPPINGS; ++i)
-			{
-				selectReport.propertyValue = WriteU32LE(i);
-				bool sendResult = reporter->Send(selectReport);
-
-				if (sendResult && reporter->Get(ledReport) && (ledReport.flags & LMF_ENABLED))
-				{
-					PrintLedMappingReport(ledReport);
-					ledMappings.push_back(ledReport);
-				}
-			}
+		// If we got some lights, try to read the light rules.
+		if (readLights && !dumped)
+		{
+			ReadLightsConfiguration(*reporter, lightRules, ledMappings);
 		}
 
 		string devicePath = "";
@@ -849,21 +1593,11 @@ public:
 		}
 
 		SensorReport sensorReport;
-		if (padVersion.IsNewer({ 1, 2 })) {
-			SetPropertyReport selectReport;
-			selectReport.propertyId = WriteU32LE(SetPropertyReport::SELECTED_SENSOR_INDEX);
-
-			for (int i = 0; i < padIdentificationV2.sensorCount; ++i)
-			{
-				selectReport.propertyValue = WriteU32LE(i);
-				bool sendResult = reporter->Send(selectReport);
-
-				if (sendResult && reporter->Get(sensorReport))
-				{
-					PrintSensorReport(sensorReport);
-					sensors.push_back(sensorReport);
-				}
-			}
+		if (dumped) {
+			// The sensors came with the configuration dump.
+		}
+		else if (padVersion.IsNewer({ 1, 2 })) {
+			ReadSensors(*reporter, padIdentificationV2.sensorCount, sensors);
 		}
 		else {
 			// Backwards compat
@@ -876,7 +1610,8 @@ public:
 					sensorReport.releaseThreshold = WriteU16LE(ReadU16LE(padConfig.sensorThresholds[i]) * ReadF32LE(padConfig.releaseThreshold));
 					sensorReport.buttonMapping = padConfig.sensorToButtonMapping[i];
 					sensorReport.resistorValue = 0;
-					sensorReport.flags = WriteU16LE(0);
+					sensorReport.flags = 0;
+					sensorReport.sampling = 0;
 
 					sensors.push_back(sensorReport);
 				}
@@ -890,7 +1625,8 @@ public:
 			padIdentificationV2,
 			lightRules,
 			ledMappings,
-			sensors);
+			sensors,
+			inputReportMode);
 
 		Log::Write(L"ConnectionManager :: new device connected [");
 		Log::Writef(L"  Name: %hs", device->State().name.c_str());
@@ -975,7 +1711,7 @@ DeviceChanges Device::Update()
 	if (device)
 	{
 		changes |= device->PopChanges();
-		if (!device->UpdateSensorValues())
+		if (!device->UpdateSensorValues() || !device->SendLedFrame() || !device->UpdateConfigBank())
 		{
 			connectionManager->DisconnectFailedDevice();
 			changes |= DCF_DEVICE;
@@ -991,6 +1727,18 @@ int Device::PollingRate()
 	return device ? device->PollingRate() : 0;
 }
 
+InputReportStats Device::ReportStats()
+{
+	auto device = connectionManager->ConnectedDevice();
+	return device ? device->ReportStats() : InputReportStats();
+}
+
+vector<ButtonEvent> Device::ReadButtonEvents()
+{
+	auto device = connectionManager->ConnectedDevice();
+	return device ? device->PopButtonEvents() : vector<ButtonEvent>();
+}
+
 const PadState* Device::Pad()
 {
 	auto device = connectionManager->ConnectedDevice();
@@ -1021,6 +1769,12 @@ const bool Device::HasUnsavedChanges()
 	return device ? device->HasUnsavedChanges() : false;
 }
 
+bool Device::IsSaving()
+{
+	auto device = connectionManager->ConnectedDevice();
+	return device ? device->IsSaving() : false;
+}
+
 bool Device::SetThreshold(int sensorIndex, double threshold)
 {
 	auto device = connectionManager->ConnectedDevice();
@@ -1033,18 +1787,48 @@ bool Device::SetReleaseThreshold(double threshold)
 	return device ? device->SetReleaseThreshold(threshold) : false;
 }
 
+bool Device::SetLightsFrameRate(int framesPerSecond)
+{
+	auto device = connectionManager->ConnectedDevice();
+	return device ? device->SetLightsFrameRate(framesPerSecond) : false;
+}
+
 bool Device::SetAdcConfig(int sensorIndex, int resistorValue)
 {
 	auto device = connectionManager->ConnectedDevice();
 	return device ? device->SetAdcConfig(sensorIndex, resistorValue) : false;
 }
 
+bool Device::SetOversampling(int sensorIndex, int oversampling)
+{
+	auto device = connectionManager->ConnectedDevice();
+	return device ? device->SetOversampling(sensorIndex, oversampling) : false;
+}
+
+bool Device::SetRateDivisor(int sensorIndex, int rateDivisor)
+{
+	auto device = connectionManager->ConnectedDevice();
+	return device ? device->SetRateDivisor(sensorIndex, rateDivisor) : false;
+}
+
+bool Device::SetSensorDisabled(int sensorIndex, bool disabled)
+{
+	auto device = connectionManager->ConnectedDevice();
+	return device ? device->SetSensorDisabled(sensorIndex, disabled) : false;
+}
+
 bool Device::SetButtonMapping(int sensorIndex, int button)
 {
 	auto device = connectionManager->ConnectedDevice();
 	return device ? device->SetButtonMapping(sensorIndex, button) : false;
 }
 
+bool Device::SetStartupInputReportMode(int mode)
+{
+	auto device = connectionManager->ConnectedDevice();
+	return device ? device->SetStartupInputReportMode(mode) : false;
+}
+
 bool Device::SetDeviceName(const char* name)
 {
 	auto device = connectionManager->ConnectedDevice();
@@ -1075,6 +1859,18 @@ bool Device::DisableLightRule(int lightRuleIndex)
 	return device ? device->DisableLightRule(lightRuleIndex) : false;
 }
 
+bool Device::StreamLedFrame(const vector<RgbColor>& colors)
+{
+	auto device = connectionManager->ConnectedDevice();
+	return device ? device->StreamLedFrame(colors) : false;
+}
+
+bool Device::SelectConfigBank(int bank)
+{
+	auto device = connectionManager->ConnectedDevice();
+	return device ? device->SelectConfigBank(bank) : false;
+}
+
 void Device::SendDeviceReset()
 {
 	auto device = connectionManager->ConnectedDevice();
@@ -1100,6 +1896,10 @@ void Device::SetSearching(bool s)
 
 void Device::LoadProfile(json& j, DeviceProfileGroups groups)
 {
+	// Pads that support it apply the whole profile at once, instead of one sensor, light rule or led mapping at a time.
+	auto device = connectionManager->ConnectedDevice();
+	ConfigWriteScope configWrite(device);
+
 	if((groups & DPG_LIGHTS) > 0 && Pad()->featureLights) {
 		if(j["ledMappings"].is_array()) {
 			for(int key = 0; key < j["ledMappings"].size(); key++) {
@@ -1133,7 +1933,6 @@ void Device::LoadProfile(json& j, DeviceProfileGroups groups)
 			}
 		}
 
-		auto device = connectionManager->ConnectedDevice();
 		if(device) {
             device->TriggerChange(DCF_LIGHTS);
 		}
@@ -1154,6 +1953,18 @@ void Device::LoadProfile(json& j, DeviceProfileGroups groups)
 			if (groups & DPG_MAPPING && sensor.contains("resistorValue") && Pad()->featureDigipot) {
 				SetAdcConfig(key, sensor["resistorValue"]);
 			}
+
+			if (groups & DPG_MAPPING && sensor.contains("disabled") && Pad()->firmwareVersion.IsNewer({ 1, 2 })) {
+				SetSensorDisabled(key, sensor["disabled"]);
+			}
+
+			if (groups & DPG_SENSITIVITY && sensor.contains("oversampling") && Pad()->featureSensorSampling) {
+				SetOversampling(key, sensor["oversampling"]);
+			}
+
+			if (groups & DPG_SENSITIVITY && sensor.contains("rateDivisor") && Pad()->featureSensorSampling) {
+				SetRateDivisor(key, sensor["rateDivisor"]);
+			}
 		}
 	}
 
@@ -1167,6 +1978,12 @@ void Device::LoadProfile(json& j, DeviceProfileGroups groups)
 		string name = j["name"];
 		SetDeviceName( ((std::string)j["name"]).c_str() );
 	}
+
+	// The values of the profile were already taken over, which the pad does not have if the commit failed.
+	if (!configWrite.Commit()) {
+		Log::Write(L"Could not apply the profile, reading back the configuration of the pad");
+		device->ReloadConfiguration();
+	}
 }
 
 void Device::SaveProfile(json& j, DeviceProfileGroups groups)
@@ -1203,11 +2020,16 @@ void Device::SaveProfile(json& j, DeviceProfileGroups groups)
 			if (groups & DPG_SENSITIVITY) {
 				j["sensors"][i]["threshold"] = Device::Sensor(i)->threshold;
 				j["sensors"][i]["releaseThreshold"] = Device::Sensor(i)->releaseThreshold;
+				if (Device::Pad()->featureSensorSampling) {
+					j["sensors"][i]["oversampling"] = Device::Sensor(i)->oversampling;
+					j["sensors"][i]["rateDivisor"] = Device::Sensor(i)->rateDivisor;
+				}
 			}
 
 			if (groups & DPG_MAPPING) {
 				j["sensors"][i]["button"] = Device::Sensor(i)->button;
 				j["sensors"][i]["resistorValue"] = Device::Sensor(i)->resistorValue;
+				j["sensors"][i]["disabled"] = Device::Sensor(i)->disabled;
 			}
 		}
 
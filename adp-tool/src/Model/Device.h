@@ -3,6 +3,7 @@
 #include "stdint.h"
 #include <string>
 #include <map>
+#include <vector>
 #include "wx/string.h"
 #include "wx/colour.h"
 
@@ -72,7 +73,12 @@ struct SensorState
 	double threshold = 0.0;
 	double releaseThreshold = 0.0;
 	double value = 0.0;
+	double peak = 0.0; // Highest conversion since the previous update, if the pad reports it.
+	double trough = 0.0; // Lowest conversion since the previous update, if the pad reports it.
 	int resistorValue = 0;
+	int oversampling = 0; // Log2 of the conversions averaged per scan.
+	int rateDivisor = 0; // Log2 of the number of scans per conversion.
+	bool disabled = false; // Disabled sensors are not scanned and read as zero.
 	int button = 0; // zero means unmapped.
 	bool pressed = false;
 
@@ -90,9 +96,39 @@ struct PadState
 	bool featureDebug;
 	bool featureDigipot;
 	bool featureLights;
+	bool featureSensorExtremes = false;
+	bool featureLedFrames = false;
+	bool featureConfigDump = false; // The whole configuration can be read in a few transfers.
+	bool featureConfigWrite = false; // Several configuration changes can be sent at once, and applied together.
+	bool featureDebugPendingFlag = false; // Debug messages only have to be read when the input reports say so.
+	bool featureDebugRecords = false; // Debug messages are sent as records, which include binary traces.
+	bool featureSensorSampling = false; // Oversampling and rate divisor of each sensor can be set.
+	int ledCount = 0;
+	int inputReportMode = -1; // SetPropertyReport::INPUT_REPORT_MODE_* the pad starts in, -1 if it does not store one.
+	int lightsFrameRate = 0; // Lights frames per second of the pad, streamed led frames are not sent any faster.
+	int configBankCount = 1; // Configurations stored on the pad, only one can be active.
+	int activeConfigBank = 0;
 	VersionType firmwareVersion = versionTypeUnknown;
 };
 
+struct InputReportStats
+{
+	bool available = false; // False if the firmware does not send report sequence numbers.
+	int64_t lostReports = 0; // Total since connecting.
+	int64_t gaps = 0; // Number of times one or more consecutive reports were lost.
+	int largestGap = 0;
+	double averageSampleAge = 0.0; // Microseconds, over the last second.
+	int maxSampleAge = 0; // Microseconds, over the last second.
+	int64_t droppedButtonEvents = 0; // Total since connecting, lost to a full queue on the pad or a failed read.
+};
+
+struct ButtonEvent
+{
+	uint32_t time = 0; // Microseconds on the pad clock, wraps around.
+	int button = 0; // Zero based button index.
+	bool pressed = false;
+};
+
 struct LedMapping
 {
 	int lightRuleIndex;
@@ -128,6 +164,8 @@ public:
 
 	static int PollingRate();
 
+	static InputReportStats ReportStats();
+
 	static const PadState* Pad();
 
 	static const LightsState* Lights();
@@ -136,18 +174,35 @@ public:
 
 	static wstring ReadDebug();
 
+	static std::vector<ButtonEvent> ReadButtonEvents();
+
 	static const bool HasUnsavedChanges();
 
+	// True while the pad writes a saved configuration to eeprom, which it does in the background.
+	static bool IsSaving();
+
 	static bool SetThreshold(int sensorIndex, double threshold);
 
+	// Sets how many lights frames per second the pad renders, zero stops the lights.
+	static bool SetLightsFrameRate(int framesPerSecond);
+
 	static bool SetAdcConfig(int sensorIndex, int resistorValue);
 
+	static bool SetOversampling(int sensorIndex, int oversampling);
+
+	static bool SetRateDivisor(int sensorIndex, int rateDivisor);
+
+	static bool SetSensorDisabled(int sensorIndex, bool disabled);
+
 	static bool SetReleaseThreshold(double threshold);
 
 	static bool SetButtonMapping(int sensorIndex, int button);
 
 	static bool SetDeviceName(const char* name);
 
+	// Stores the input report mode the pad starts in, for example the joystick axes so games can read it.
+	static bool SetStartupInputReportMode(int mode);
+
 	static bool SendLedMapping(int ledMappingIndex, LedMapping mapping);
 
 	static bool DisableLedMapping(int ledMappingIndex);
@@ -156,6 +211,15 @@ public:
 
 	static bool DisableLightRule(int lightRuleIndex);
 
+	// Shows colors computed on the pc instead of the light rules, one color per led. The pad goes back
+	// to its light rules when frames stop for a second. Frames are limited to the pad's lights frame rate,
+	// and only the leds that changed since the previous frame are sent.
+	static bool StreamLedFrame(const std::vector<RgbColor>& colors);
+
+	// Makes the pad load another of its stored configurations. The pad switches once pending changes are
+	// saved, Update reads the configuration back then and reports the changes.
+	static bool SelectConfigBank(int bank);
+
 	static void SendDeviceReset();
 
 	static void SendFactoryReset();
@@ -120,6 +120,9 @@ FlashResult FirmwareUploader::UpdateFirmware(wstring fileName)
 	configBackup = new json;
 	Device::SaveProfile(*configBackup, DeviceProfileGroupFlags::DGP_ALL);
 	Log::Write(L"Saved device config");
+
+	// Firmware from v1.4 migrates the configuration stored by v1.3 and later.
+	configMigratable = pad->firmwareVersion.IsNewer({ 1, 2 });
 	Device::SendDeviceReset();
 
 	while (!foundNewPort)
@@ -258,7 +261,12 @@ void FirmwareUploader::WritingDone(int exitCode)
 		this_thread::sleep_for(100ms);
 	} while (!Device::Pad());
 
-	if (configBackup) {
+	// The backup is kept for when the new firmware did not take over the stored configuration.
+	auto pad = Device::Pad();
+	if (configBackup && configMigratable && pad && pad->firmwareVersion.IsNewer({ 1, 3 })) {
+		Log::Write(L"Device migrated its config");
+	}
+	else if (configBackup) {
 		try {
 			Device::LoadProfile(*configBackup, DeviceProfileGroupFlags::DGP_ALL);
 			Device::SaveChanges();
@@ -67,6 +67,7 @@ private:
 	wstring errorMessage;
 	FlashResult flashResult = FLASHRESULT_NOTHING;
 	json* configBackup = NULL;
+	bool configMigratable = false;
 	bool ignoreBoardType = false;
 };
 
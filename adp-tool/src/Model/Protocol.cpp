@@ -0,0 +1,191 @@
+#include "Adp.h"
+
+#include <cstring>
+
+#include "Model/Protocol.h"
+
+using namespace std;
+
+namespace adp {
+
+// ====================================================================================================================
+// Helper functions.
+// ====================================================================================================================
+
+static int ReadU16LE(uint16_le u16)
+{
+	return u16.bytes[0] | u16.bytes[1] << 8;
+}
+
+static uint16_le WriteU16LE(int value)
+{
+	uint16_le result;
+	result.bytes[0] = value & 0xFF;
+	result.bytes[1] = (value >> 8) & 0xFF;
+	return result;
+}
+
+// ====================================================================================================================
+// Sensor values.
+// ====================================================================================================================
+
+int UnpackSensorValues(const uint8_t* packed, int size, int sensorMask, uint16_le* values)
+{
+	int bit = 0;
+
+	for (int i = 0; i < MAX_SENSOR_COUNT; ++i)
+	{
+		int value = 0;
+		if (sensorMask & (1 << i))
+		{
+			if ((bit + COMPACT_SENSOR_BITS + 7) / 8 > size)
+				return -1;
+
+			int word = packed[bit / 8] | (packed[bit / 8 + 1] << 8);
+			value = (word >> (bit % 8)) & ((1 << COMPACT_SENSOR_BITS) - 1);
+			bit += COMPACT_SENSOR_BITS;
+		}
+		values[i].bytes[0] = value & 0xFF;
+		values[i].bytes[1] = (value >> 8) & 0xFF;
+	}
+
+	return (bit + 7) / 8;
+}
+
+// The compact report only carries the wired sensors, packed at COMPACT_SENSOR_BITS each.
+// Layout: report id, button bits (2 bytes), sensor mask (2 bytes), packed values, trailer.
+// The extremes report has packed peaks and troughs between the values and the trailer.
+bool DecodeCompactSensorValues(const uint8_t* buffer, int size, SensorValuesReport& report)
+{
+	constexpr int headerSize = 5;
+	if (size < headerSize)
+		return false;
+
+	int sensorMask = buffer[3] | (buffer[4] << 8);
+	int offset = headerSize;
+
+	memcpy(&report.buttonBits, buffer + 1, sizeof(report.buttonBits));
+
+	int groupSize = UnpackSensorValues(buffer + offset, size - offset, sensorMask, report.sensorValues);
+	if (groupSize < 0)
+		return false;
+	offset += groupSize;
+
+	report.hasExtremes = buffer[0] == REPORT_EXTREMES_SENSOR_VALUES;
+	if (report.hasExtremes)
+	{
+		for (auto values : { report.sensorPeaks, report.sensorTroughs })
+		{
+			groupSize = UnpackSensorValues(buffer + offset, size - offset, sensorMask, values);
+			if (groupSize < 0)
+				return false;
+			offset += groupSize;
+		}
+	}
+
+	report.hasTrailer = offset + (int)sizeof(InputReportTrailer) <= size;
+	if (report.hasTrailer)
+		memcpy(&report.trailer, buffer + offset, sizeof(InputReportTrailer));
+
+	return true;
+}
+
+// ====================================================================================================================
+// Configuration.
+// ====================================================================================================================
+
+// The pad continues where the previous reader stopped, so the pages are placed by their offset.
+bool PlaceConfigDumpPage(const ConfigDumpReport& page, int size, uint8_t* configuration)
+{
+	int offset = ReadU16LE(page.offset);
+	if (offset >= size || offset % ConfigDumpReport::PAGE_SIZE != 0)
+		return false;
+
+	memcpy(configuration + offset, page.data, min(size - offset, ConfigDumpReport::PAGE_SIZE));
+	return true;
+}
+
+vector<ConfigWriteTransaction> BatchConfigWrites(const map<int, vector<uint8_t>>& writes)
+{
+	vector<ConfigWriteTransaction> transactions;
+	int transactionSize = ConfigWriteReport::TRANSACTION_SIZE;
+
+	for (auto& [offset, bytes] : writes)
+	{
+		int recordSize = sizeof(ConfigWriteReport::Record) + (int)bytes.size();
+
+		if (transactionSize + recordSize > ConfigWriteReport::TRANSACTION_SIZE)
+		{
+			transactions.emplace_back();
+			transactionSize = 0;
+		}
+
+		auto& reports = transactions.back();
+		if (reports.empty() || reports.back().size + recordSize > ConfigWriteReport::RECORDS_SIZE)
+		{
+			reports.emplace_back();
+			reports.back().size = 0;
+		}
+
+		auto& report = reports.back();
+		ConfigWriteReport::Record record;
+		record.offset = WriteU16LE(offset);
+		record.length = (uint8_t)bytes.size();
+		memcpy(report.records + report.size, &record, sizeof(record));
+		memcpy(report.records + report.size + sizeof(record), bytes.data(), bytes.size());
+		report.size += recordSize;
+		transactionSize += recordSize;
+	}
+
+	return transactions;
+}
+
+// ====================================================================================================================
+// Debug records.
+// ====================================================================================================================
+
+DecodedDebugRecords DecodeDebugRecords(const uint8_t* bytes, size_t size)
+{
+	DecodedDebugRecords decoded;
+	size_t position = 0;
+
+	while (position < size)
+	{
+		const uint8_t* record = bytes + position;
+
+		if (record[0] == DEBUG_RECORD_TEXT)
+		{
+			DebugTextRecord text;
+			if (position + sizeof(text) > size)
+				break;
+
+			memcpy(&text, record, sizeof(text));
+			if (position + sizeof(text) + text.length > size)
+				break;
+
+			decoded.text.append((const char*)record + sizeof(text), text.length);
+			position += sizeof(text) + text.length;
+		}
+		else if (record[0] == DEBUG_RECORD_TRACE)
+		{
+			DebugTraceRecord trace;
+			if (position + sizeof(trace) > size)
+				break;
+
+			memcpy(&trace, record, sizeof(trace));
+			decoded.traces.push_back(trace);
+			position += sizeof(trace);
+		}
+		else
+		{
+			// The records can not be told apart anymore.
+			decoded.unknownType = record[0];
+			position = size;
+		}
+	}
+
+	decoded.size = position;
+	return decoded;
+}
+
+}; // namespace adp.
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "Model/Reporter.h"
+
+namespace adp {
+
+// Unpacks one group of values packed at COMPACT_SENSOR_BITS each, one for every bit in sensorMask.
+// Returns the number of bytes the group takes up, or -1 if it does not fit in size.
+int UnpackSensorValues(const uint8_t* packed, int size, int sensorMask, uint16_le* values);
+
+// Decodes a compact or extremes sensor values report, starting with its report id.
+// Returns false if the packed values do not fit in size.
+bool DecodeCompactSensorValues(const uint8_t* buffer, int size, SensorValuesReport& report);
+
+// Copies a config dump page to its offset within the configuration, which is size bytes.
+// Returns false if the offset is not the start of a page within the configuration.
+bool PlaceConfigDumpPage(const ConfigDumpReport& page, int size, uint8_t* configuration);
+
+struct DecodedDebugRecords
+{
+	std::string text; // Of the text records, back to back.
+	std::vector<DebugTraceRecord> traces;
+	size_t size = 0; // Bytes decoded, the rest is the start of a record that is split over debug reports.
+	int unknownType = -1; // Type of a record that could not be decoded, all bytes from there on are skipped.
+};
+
+// Decodes the complete debug records at the start of bytes.
+DecodedDebugRecords DecodeDebugRecords(const uint8_t* bytes, size_t size);
+
+// The config write reports sent between the begin and commit of one config transaction.
+typedef std::vector<ConfigWriteReport> ConfigWriteTransaction;
+
+// Packs writes, bytes by their offset within ConfigurationV2, into as few reports as possible. Writes that do
+// not fit in one transaction of the pad, ConfigWriteReport::TRANSACTION_SIZE, are split over several.
+std::vector<ConfigWriteTransaction> BatchConfigWrites(const std::map<int, std::vector<uint8_t>>& writes);
+
+}; // namespace adp.
@@ -1,10 +1,12 @@
 #include "Adp.h"
 
+#include <algorithm>
 #include <cstring>
 #include <chrono>
 #include <thread>
 
 #include "Model/Reporter.h"
+#include "Model/Protocol.h"
 #include "Model/Log.h"
 #include "Model/Utils.h"
 
@@ -16,6 +18,11 @@ namespace adp {
 // Helper functions.
 // ====================================================================================================================
 
+static int ReadU16LE(uint16_le u16)
+{
+	return u16.bytes[0] | u16.bytes[1] << 8;
+}
+
 template <typename T>
 static bool GetFeatureReport(hid_device* hid, T& report, const wchar_t* name)
 {
@@ -62,22 +69,36 @@ static bool SendFeatureReport(hid_device* hid, const T& report, const wchar_t* n
 	return false;
 }
 
-template <typename T>
-static ReadDataResult ReadData(hid_device* hid, T& report, const wchar_t* name)
+static ReadDataResult ReadData(hid_device* hid, SensorValuesReport& report, const wchar_t* name)
 {
 	uint8_t buffer[MAX_REPORT_SIZE];
 	buffer[0] = report.reportId;
 
 	int bytesRead = hid_read(hid, buffer, sizeof(buffer));
-	if (bytesRead == sizeof(SensorValuesReport))
+
+	// Some platforms pad input reports to the size of the largest one, so reports are told apart
+	// by their id, and may be longer than expected. Older firmware sends the report without the trailer.
+	if (bytesRead >= SENSOR_VALUES_REPORT_SIZE_V1 && buffer[0] == REPORT_SENSOR_VALUES)
 	{
-		memcpy(&report, buffer, sizeof(SensorValuesReport));
+		int size = min(bytesRead, SENSOR_VALUES_REPORT_SIZE_V2);
+		memcpy(&report, buffer, size);
+		report.hasTrailer = size == SENSOR_VALUES_REPORT_SIZE_V2;
+		report.hasExtremes = false;
 		return ReadDataResult::SUCCESS;
 	}
 
+	// The compact report is decoded from its sensor mask rather than the number of bytes read.
+	bool compact = buffer[0] == REPORT_COMPACT_SENSOR_VALUES || buffer[0] == REPORT_EXTREMES_SENSOR_VALUES;
+	if (bytesRead > 0 && compact && DecodeCompactSensorValues(buffer, bytesRead, report))
+		return ReadDataResult::SUCCESS;
+
 	if (bytesRead == 0)
 		return ReadDataResult::NO_DATA;
 
+	// Pads that start as a joystick send axes reports until the tool switches the mode.
+	if (bytesRead > 0 && buffer[0] == REPORT_AXES_SENSOR_VALUES)
+		return ReadDataResult::IGNORED;
+
 	if (bytesRead < 0)
 		Log::Writef(L"%ls :: hid_read failed (%ls)", name, hid_error(hid));
 	else
@@ -86,6 +107,22 @@ static ReadDataResult ReadData(hid_device* hid, T& report, const wchar_t* name)
 	return ReadDataResult::FAILURE;
 }
 
+template <typename T>
+static bool SendOutputReport(hid_device* hid, const T& report, const wchar_t* name)
+{
+	// Output reports are not answered, so there is no need to wait for the controller here.
+	int bytesWritten = hid_write(hid, (const unsigned char*)&report, sizeof(T));
+	if (bytesWritten == sizeof(T))
+		return true;
+
+	if (bytesWritten < 0)
+		Log::Writef(L"%ls :: hid_write failed (%ls)", name, hid_error(hid));
+	else
+		Log::Writef(L"%ls :: unexpected number of bytes written (%i)", name, bytesWritten);
+
+	return false;
+}
+
 static bool WriteData(hid_device* hid, uint8_t reportId, const wchar_t* name, bool performErrorCheck)
 {
 	// Linux wants reports of at leats 2 bytes
@@ -216,6 +253,77 @@ bool Reporter::Get(DebugReport& report)
 	return GetFeatureReport(myHid, report, L"GetDebugReport");
 }
 
+bool Reporter::Get(ButtonEventsReport& report)
+{
+	if (emulator) {
+		report.count = 0;
+		report.dropped = 0;
+		return true;
+	}
+
+	return GetFeatureReport(myHid, report, L"GetButtonEventsReport");
+}
+
+bool Reporter::Get(ConfigBanksReport& report)
+{
+	if (emulator) {
+		report.bankCount = 1;
+		report.activeBank = 0;
+		return true;
+	}
+
+	return GetFeatureReport(myHid, report, L"GetConfigBanksReport");
+}
+
+bool Reporter::Get(MemoryUsageReport& report)
+{
+	if (emulator) {
+		return false;
+	}
+
+	return GetFeatureReport(myHid, report, L"GetMemoryUsageReport");
+}
+
+bool Reporter::Get(ConfigurationV2& configuration, int& layoutVersion)
+{
+	if (emulator) {
+		return false;
+	}
+
+	ConfigDumpReport page;
+	if (!GetFeatureReport(myHid, page, L"GetConfigDumpReport")) {
+		return false;
+	}
+
+	// Later layouts only add fields at the end, so the version 1 fields are at the same place.
+	int size = ReadU16LE(page.size);
+	bool supported = (page.layoutVersion == ConfigurationV1::LAYOUT_VERSION && size == sizeof(ConfigurationV1))
+		|| (page.layoutVersion == ConfigurationV2::LAYOUT_VERSION && size == sizeof(ConfigurationV2));
+	if (!supported)
+	{
+		Log::Writef(L"GetConfigDumpReport :: unsupported layout (%i) or size (%i)", page.layoutVersion, size);
+		return false;
+	}
+	layoutVersion = page.layoutVersion;
+
+	auto bytes = (uint8_t*)&configuration;
+	int pageCount = (size + ConfigDumpReport::PAGE_SIZE - 1) / ConfigDumpReport::PAGE_SIZE;
+	for (int i = 0; i < pageCount; ++i)
+	{
+		if (i > 0 && !GetFeatureReport(myHid, page, L"GetConfigDumpReport")) {
+			return false;
+		}
+
+		if (!PlaceConfigDumpPage(page, size, bytes))
+		{
+			Log::Writef(L"GetConfigDumpReport :: unexpected offset (%i)", ReadU16LE(page.offset));
+			return false;
+		}
+	}
+
+	return true;
+}
+
 void Reporter::SendReset()
 {
 	WriteData(myHid, REPORT_RESET, L"SendResetReport", false);
@@ -285,6 +393,24 @@ bool Reporter::Send(const SetPropertyReport& report)
 	return SendFeatureReport(myHid, report, L"SendSetPropertyReport");
 }
 
+bool Reporter::Send(const ConfigWriteReport& report)
+{
+	if(emulator) {
+		return true;
+	}
+
+	return SendFeatureReport(myHid, report, L"SendConfigWriteReport");
+}
+
+bool Reporter::Send(const LedFrameReport& report)
+{
+	if(emulator) {
+		return true;
+	}
+
+	return SendOutputReport(myHid, report, L"SendLedFrameReport");
+}
+
 bool Reporter::SendAndGet(NameReport& report)
 {
 	if(!Send(report))
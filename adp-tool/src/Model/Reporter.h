@@ -22,6 +22,9 @@ constexpr int BOARD_TYPE_LENGTH = 32;
 
 constexpr size_t MAX_REPORT_SIZE = 512;
 
+// Bits per sensor value in the compact sensor values report.
+constexpr int COMPACT_SENSOR_BITS = 10;
+
 enum ReportId
 {
 	REPORT_SENSOR_VALUES      = 0x1,
@@ -38,6 +41,15 @@ enum ReportId
 	REPORT_SENSOR			  = 0xC,
 	REPORT_DEBUG			  = 0xD,
 	REPORT_IDENTIFICATION_V2  = 0xE,
+	REPORT_COMPACT_SENSOR_VALUES = 0xF,
+	REPORT_BUTTON_EVENTS      = 0x10,
+	REPORT_EXTREMES_SENSOR_VALUES = 0x11,
+	REPORT_LED_FRAME          = 0x12,
+	REPORT_CONFIG_BANKS       = 0x13,
+	REPORT_MEMORY_USAGE       = 0x14,
+	REPORT_CONFIG_DUMP        = 0x15,
+	REPORT_CONFIG_WRITE       = 0x16,
+	REPORT_AXES_SENSOR_VALUES = 0x17,
 };
 
 enum class ReadDataResult
@@ -45,6 +57,7 @@ enum class ReadDataResult
 	NO_DATA,
 	SUCCESS,
 	FAILURE,
+	IGNORED, // A report the tool does not use, like the joystick axes sent before the tool switched the mode.
 };
 
 struct uint16_le { uint8_t bytes[2]; };
@@ -53,13 +66,42 @@ struct color24 { uint8_t red, green, blue; };
 
 struct float32_le { uint32_le bits; };
 
+// Appended to the sensor values reports by newer firmware.
+struct InputReportTrailer
+{
+	enum Flags
+	{
+		BUTTON_EVENTS_PENDING = 1 << 0,
+		SAVE_PENDING = 1 << 1, // The pad is still writing its configuration to eeprom.
+		DEBUG_PENDING = 1 << 2, // Debug messages can be read with the debug report.
+	};
+
+	uint8_t sequence; // Incremented for every report sent by the pad, wraps around.
+	uint16_le sampleAge; // Microseconds from the end of the sensor scan until the report was sent.
+	uint8_t flags;
+};
+
 struct SensorValuesReport
 {
 	uint8_t reportId = REPORT_SENSOR_VALUES;
 	uint16_le buttonBits;
 	uint16_le sensorValues[MAX_SENSOR_COUNT];
+	InputReportTrailer trailer;
+
+	// Not part of the report data, set when the trailer was received.
+	bool hasTrailer = false;
+
+	// Not part of the standard report. Highest and lowest conversions since the previous report,
+	// only set when the extremes report was received.
+	bool hasExtremes = false;
+	uint16_le sensorPeaks[MAX_SENSOR_COUNT];
+	uint16_le sensorTroughs[MAX_SENSOR_COUNT];
 };
 
+// Size of the sensor values report sent by firmware without the trailer.
+constexpr int SENSOR_VALUES_REPORT_SIZE_V1 = 1 + sizeof(uint16_le) + sizeof(uint16_le) * MAX_SENSOR_COUNT;
+constexpr int SENSOR_VALUES_REPORT_SIZE_V2 = SENSOR_VALUES_REPORT_SIZE_V1 + sizeof(InputReportTrailer);
+
 struct PadConfigurationReport
 {
 	uint8_t reportId = REPORT_PAD_CONFIGURATION;
@@ -99,6 +141,19 @@ struct IdentificationV2Report : public IdentificationReport
 		FEATURE_DEBUG = 1 << 0,
 		FEATURE_DIGIPOT = 1 << 1,
 		FEATURE_LIGHTS = 1 << 2,
+		FEATURE_COMPACT_INPUT_REPORT = 1 << 3,
+		FEATURE_INPUT_REPORT_ON_CHANGE = 1 << 4,
+		FEATURE_BUTTON_EVENTS = 1 << 5,
+		FEATURE_SENSOR_EXTREMES = 1 << 6,
+		FEATURE_LED_FRAMES = 1 << 7,
+		FEATURE_CONFIG_BANKS = 1 << 8,
+		FEATURE_MEMORY_USAGE = 1 << 9,
+		FEATURE_CONFIG_DUMP = 1 << 10,
+		FEATURE_CONFIG_WRITE = 1 << 11,
+		FEATURE_AXES_INPUT_REPORT = 1 << 12, // Sensors can be sent as joystick axes, for games. Not used by adp-tool.
+		FEATURE_DEBUG_PENDING_FLAG = 1 << 13, // The input report trailer tells when debug messages are pending.
+		FEATURE_DEBUG_RECORDS = 1 << 14, // The debug reports carry text and trace records instead of plain text.
+		FEATURE_SENSOR_SAMPLING = 1 << 15, // Sensors can be oversampled and converted less often, see SensorReport::sampling.
 	};
 
 	uint16_le features;
@@ -133,13 +188,20 @@ struct SensorReport
 		ADC_DISABLED		= 1 << 0,
 	};
 
+	static constexpr int OVERSAMPLING_MASK = 0x0F;
+	static constexpr int MAX_OVERSAMPLING_SHIFT = 4;
+	static constexpr int RATE_DIVISOR_MASK = 0xF0;
+	static constexpr int RATE_DIVISOR_SHIFT = 4;
+	static constexpr int MAX_RATE_DIVISOR_SHIFT = 4;
+
 	uint8_t reportId = REPORT_SENSOR;
 	uint8_t index;
 	uint16_le threshold;
 	uint16_le releaseThreshold;
 	int8_t buttonMapping;
 	uint8_t resistorValue;
-	uint16_le flags;
+	uint8_t flags;
+	uint8_t sampling; // Low nibble: log2 of the conversions per scan. High nibble: log2 of the scans per conversion.
 };
 
 struct SetPropertyReport
@@ -148,13 +210,178 @@ struct SetPropertyReport
 	{
 		SELECTED_LIGHT_RULE_INDEX = 0,
 		SELECTED_LED_MAPPING_INDEX = 1,
-		SELECTED_SENSOR_INDEX = 2
+		SELECTED_SENSOR_INDEX = 2,
+		INPUT_REPORT_MODE = 3,
+		INPUT_REPORT_THRESHOLD = 4,
+		INPUT_REPORT_IDLE = 5,
+		LIGHTS_FRAME_RATE = 6,
+		CONFIG_BANK = 7,
+		CONFIG_TRANSACTION = 8,
+		SCAN_ALL_SENSORS = 9 // Non-zero to also scan sensors that press no button and drive no light.
+	};
+
+	enum ConfigTransactions
+	{
+		CONFIG_TRANSACTION_ABORT = 0,
+		CONFIG_TRANSACTION_BEGIN = 1, // Following config writes are staged on the pad.
+		CONFIG_TRANSACTION_COMMIT = 2 // The staged config writes are applied at once.
 	};
+
+	enum InputReportModes
+	{
+		INPUT_REPORT_MODE_STANDARD = 0,
+		INPUT_REPORT_MODE_COMPACT = 1,
+		INPUT_REPORT_MODE_EXTREMES = 2,
+		INPUT_REPORT_MODE_AXES = 3
+	};
+
 	uint8_t reportId = REPORT_SET_PROPERTY;
 	uint32_le propertyId;
 	uint32_le propertyValue;
 };
 
+struct ConfigBanksReport
+{
+	uint8_t reportId = REPORT_CONFIG_BANKS;
+	uint8_t bankCount; // Number of configurations the pad can store.
+	uint8_t activeBank;
+};
+
+struct MemoryUsageReport
+{
+	uint8_t reportId = REPORT_MEMORY_USAGE;
+	uint16_le ramSize; // Bytes.
+	uint16_le staticSize; // Taken by static variables.
+	uint16_le free; // Between the static variables and the stack, when the report was requested.
+	uint16_le stackHighWater; // Most the stack used since the pad was reset.
+};
+
+// A page of the configuration the pad runs with. Every read returns the next page, wrapping around after the last.
+struct ConfigDumpReport
+{
+	static constexpr int PAGE_SIZE = 56;
+
+	uint8_t reportId = REPORT_CONFIG_DUMP;
+	uint8_t layoutVersion;
+	uint16_le offset; // Of data within the configuration.
+	uint16_le size; // Of the configuration.
+	uint8_t data[PAGE_SIZE];
+};
+
+// The configuration assembled from config dump pages with layout version 1.
+struct ConfigurationV1
+{
+	static constexpr int LAYOUT_VERSION = 1;
+
+	struct Sensor
+	{
+		uint16_le threshold;
+		uint16_le releaseThreshold;
+		int8_t buttonMapping;
+		uint8_t resistorValue;
+		uint8_t flags;
+		uint8_t sampling;
+	};
+
+	struct LightRule
+	{
+		uint8_t flags;
+		color24 onColor;
+		color24 offColor;
+		color24 onFadeColor;
+		color24 offFadeColor;
+	};
+
+	struct LedMapping
+	{
+		uint8_t flags;
+		uint8_t lightRuleIndex;
+		uint8_t sensorIndex;
+		uint8_t ledIndexBegin;
+		uint8_t ledIndexEnd;
+	};
+
+	Sensor sensors[MAX_SENSOR_COUNT];
+	uint8_t selectedSensorIndex;
+	uint8_t nameSize;
+	uint8_t name[MAX_NAME_LENGTH];
+	LightRule lightRules[MAX_LIGHT_RULES];
+	LedMapping ledMappings[MAX_LED_MAPPINGS];
+	uint8_t selectedLightRuleIndex;
+	uint8_t selectedLedMappingIndex;
+};
+
+// The configuration with layout version 2, which added the input report mode after the version 1 fields.
+struct ConfigurationV2
+{
+	static constexpr int LAYOUT_VERSION = 2;
+
+	ConfigurationV1 v1;
+	uint8_t inputReportMode; // SetPropertyReport::INPUT_REPORT_MODE_*, the mode the pad starts in.
+};
+
+// The sensor, light rule and led mapping reports carry the same bytes as the configuration, after their index.
+static_assert(sizeof(SensorReport) == 2 + sizeof(ConfigurationV1::Sensor), "SensorReport does not match the configuration");
+static_assert(sizeof(LightRuleReport) == 2 + sizeof(ConfigurationV1::LightRule), "LightRuleReport does not match the configuration");
+static_assert(sizeof(LedMappingReport) == 2 + sizeof(ConfigurationV1::LedMapping), "LedMappingReport does not match the configuration");
+
+// Writes bytes of the configuration, either right away or when a config transaction is committed.
+struct ConfigWriteReport
+{
+	static constexpr int RECORDS_SIZE = 60;
+
+	// Bytes of records the pad stages for one transaction, larger transactions are dropped.
+	static constexpr int TRANSACTION_SIZE = 160;
+
+	// Followed by length bytes, written at offset within ConfigurationV2.
+	struct Record
+	{
+		uint16_le offset;
+		uint8_t length;
+	};
+
+	uint8_t reportId = REPORT_CONFIG_WRITE;
+	uint8_t size; // Bytes of records used.
+	uint8_t records[RECORDS_SIZE];
+};
+
+struct ButtonEventsReport
+{
+	static constexpr int MAX_EVENTS = 8;
+
+	// Set on the button index of an event when the button was pressed.
+	static constexpr int BUTTON_PRESSED = 0x80;
+
+	struct Event
+	{
+		uint32_le time; // Microseconds, on the pad clock.
+		uint8_t button;
+	};
+
+	uint8_t reportId = REPORT_BUTTON_EVENTS;
+	uint8_t count;
+	uint8_t dropped;
+	Event events[MAX_EVENTS];
+};
+
+// Output report, writes a run of led colors into the frame streamed to the pad.
+struct LedFrameReport
+{
+	enum Flags
+	{
+		SHOW = 1 << 0, // Show the frame once all runs before this one are written.
+		STOP = 1 << 1, // Go back to the light rules.
+	};
+
+	static constexpr int MAX_LEDS = 20;
+
+	uint8_t reportId = REPORT_LED_FRAME;
+	uint8_t flags;
+	uint8_t ledIndex;
+	uint8_t ledCount;
+	color24 colors[MAX_LEDS];
+};
+
 struct DebugReport
 {
 	uint8_t reportId = REPORT_DEBUG;
@@ -162,6 +389,38 @@ struct DebugReport
 	char messagePacket[32];
 };
 
+// Debug reports of pads with FEATURE_DEBUG_RECORDS carry these records back to back, which may be split
+// over several reports. Each starts with its type.
+enum DebugRecordType
+{
+	DEBUG_RECORD_TEXT = 0x1,
+	DEBUG_RECORD_TRACE = 0x2,
+};
+
+// Followed by length characters.
+struct DebugTextRecord
+{
+	uint8_t type;
+	uint8_t length;
+};
+
+struct DebugTraceRecord
+{
+	enum Events
+	{
+		DROPPED = 0, // Records lost to a full buffer on the pad.
+		CONFIG_STORED = 1, // Bank the configuration was stored to.
+		CONFIG_BANK_SELECTED = 2, // Bank.
+		INPUT_REPORT_MODE = 3, // Mode.
+		LIGHTS_FRAME_SKIPPED = 4, // The previous frame was still being sent.
+	};
+
+	uint8_t type;
+	uint8_t event;
+	uint16_le args[2];
+	uint32_le time; // Microseconds on the pad clock.
+};
+
 #pragma pack()
 
 class Reporter
@@ -180,6 +439,13 @@ public:
 	bool Get(LedMappingReport& report);
 	bool Get(SensorReport& report);
 	bool Get(DebugReport& report);
+	bool Get(ButtonEventsReport& report);
+	bool Get(ConfigBanksReport& report);
+	bool Get(MemoryUsageReport& report);
+
+	// Reads every config dump page, which takes a handful of transfers instead of a select and get per item.
+	// Sets layoutVersion to the layout the pad sent. Fields the layout does not have keep their value.
+	bool Get(ConfigurationV2& configuration, int& layoutVersion);
 
 	void SendReset();
 	void SendFactoryReset();
@@ -190,6 +456,8 @@ public:
 	bool Send(const LedMappingReport& report);
 	bool Send(const SensorReport& report);
 	bool Send(const SetPropertyReport& report);
+	bool Send(const LedFrameReport& report);
+	bool Send(const ConfigWriteReport& report);
 
 
 	bool SendAndGet(NameReport& report);
@@ -17,7 +17,7 @@ struct VersionType {
 	uint16_t major;
 	uint16_t minor;
 
-	bool IsNewer(VersionType then)
+	bool IsNewer(VersionType then) const
 	{
 		if (major > then.major) {
 			return true;
@@ -4,6 +4,7 @@
 
 #include "wx/dataview.h"
 #include "wx/button.h"
+#include "wx/checkbox.h"
 #include "wx/generic/textdlgg.h"
 #include "wx/filedlg.h"
 #include "wx/msgdlg.h"
@@ -31,9 +32,12 @@ static constexpr const wchar_t* FactoryResetMsg =
 static constexpr const wchar_t* UpdateFirmwareMsg =
     L"Upload a firmware file to the pad device.";
 
+static constexpr const wchar_t* JoystickMsg =
+    L"Report the sensors as joystick axes when the tool\nis not running, so games can read how hard a\npanel is pressed. Saved with the configuration.";
+
 const wchar_t* DeviceTab::Title = L"Device";
 
-enum Ids { RENAME_BUTTON = 1, FACTORY_RESET_BUTTON = 2, REBOOT_BUTTON = 3, FIRMWARE_BUTTON = 4, FIRMWARE_CANCEL_BUTTON = 5};
+enum Ids { RENAME_BUTTON = 1, FACTORY_RESET_BUTTON = 2, REBOOT_BUTTON = 3, FIRMWARE_BUTTON = 4, FIRMWARE_CANCEL_BUTTON = 5, JOYSTICK_CHECKBOX = 6};
 
 DeviceTab::DeviceTab(wxWindow* owner)
     : wxWindow(owner, wxID_ANY)
@@ -47,6 +51,18 @@ DeviceTab::DeviceTab(wxWindow* owner)
     auto bRename = new wxButton(this, RENAME_BUTTON, L"Rename...", wxDefaultPosition, wxSize(200, -1));
     sizer->Add(bRename, 0, wxALIGN_CENTER_HORIZONTAL | wxTOP, 5);
 
+    // Only pads that store the input report mode in their configuration can start as a joystick.
+    auto pad = Device::Pad();
+    if (pad && pad->inputReportMode >= 0)
+    {
+        auto lJoystick = new wxStaticText(this, wxID_ANY, JoystickMsg,
+            wxDefaultPosition, wxDefaultSize, wxALIGN_CENTRE_HORIZONTAL);
+        sizer->Add(lJoystick, 0, wxALIGN_CENTER_HORIZONTAL | wxTOP, 20);
+        auto cJoystick = new wxCheckBox(this, JOYSTICK_CHECKBOX, L"Joystick axes", wxDefaultPosition, wxSize(200, -1));
+        cJoystick->SetValue(pad->inputReportMode == SetPropertyReport::INPUT_REPORT_MODE_AXES);
+        sizer->Add(cJoystick, 0, wxALIGN_CENTER_HORIZONTAL | wxTOP, 5);
+    }
+
     auto lReset = new wxStaticText(this, wxID_ANY, FactoryResetMsg,
         wxDefaultPosition, wxDefaultSize, wxALIGN_CENTRE_HORIZONTAL);
     sizer->Add(lReset, 0, wxALIGN_CENTER_HORIZONTAL | wxTOP, 20);
@@ -88,6 +104,13 @@ void DeviceTab::OnRename(wxCommandEvent& event)
         Device::SetDeviceName(dlg.GetValue());
 }
 
+void DeviceTab::OnJoystickToggled(wxCommandEvent& event)
+{
+    Device::SetStartupInputReportMode(event.IsChecked()
+        ? SetPropertyReport::INPUT_REPORT_MODE_AXES
+        : SetPropertyReport::INPUT_REPORT_MODE_STANDARD);
+}
+
 void DeviceTab::OnFactoryReset(wxCommandEvent& event)
 {
     Device::SendFactoryReset();
@@ -111,6 +134,7 @@ void DeviceTab::OnUploadFirmware(wxCommandEvent& event)
 
 BEGIN_EVENT_TABLE(DeviceTab, wxWindow)
     EVT_BUTTON(RENAME_BUTTON, DeviceTab::OnRename)
+    EVT_CHECKBOX(JOYSTICK_CHECKBOX, DeviceTab::OnJoystickToggled)
     EVT_BUTTON(FACTORY_RESET_BUTTON, DeviceTab::OnFactoryReset)
     EVT_BUTTON(REBOOT_BUTTON, DeviceTab::OnReboot)
     EVT_BUTTON(FIRMWARE_BUTTON, DeviceTab::OnUploadFirmware)
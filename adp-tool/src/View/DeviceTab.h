@@ -41,6 +41,7 @@ public:
     DeviceTab(wxWindow* owner);
 
     void OnRename(wxCommandEvent& event);
+    void OnJoystickToggled(wxCommandEvent& event);
     void OnReboot(wxCommandEvent& event);
     void OnFactoryReset(wxCommandEvent& event);
     void OnUploadFirmware(wxCommandEvent& event);
@@ -0,0 +1,67 @@
+#include <algorithm>
+#include <vector>
+
+#include "Model/Protocol.h"
+#include "Test.h"
+
+using namespace std;
+using namespace adp;
+
+// The page of the configuration at offset, as the pad sends it.
+static ConfigDumpReport Page(const vector<uint8_t>& configuration, int offset)
+{
+	ConfigDumpReport page = {};
+	page.layoutVersion = ConfigurationV2::LAYOUT_VERSION;
+	page.offset.bytes[0] = offset & 0xFF;
+	page.offset.bytes[1] = offset >> 8;
+	page.size.bytes[0] = configuration.size() & 0xFF;
+	page.size.bytes[1] = configuration.size() >> 8;
+
+	for (int i = 0; i < ConfigDumpReport::PAGE_SIZE && offset + i < (int)configuration.size(); ++i)
+		page.data[i] = configuration[offset + i];
+
+	return page;
+}
+
+static vector<uint8_t> SampleConfiguration()
+{
+	vector<uint8_t> configuration(sizeof(ConfigurationV2));
+	for (size_t i = 0; i < configuration.size(); ++i)
+		configuration[i] = (uint8_t)(i * 7 + 1);
+	return configuration;
+}
+
+TEST(ConfigDumpPagesArePlacedByOffset)
+{
+	auto configuration = SampleConfiguration();
+	int size = (int)configuration.size();
+	int pageCount = (size + ConfigDumpReport::PAGE_SIZE - 1) / ConfigDumpReport::PAGE_SIZE;
+
+	// A previous reader stopped after the third page, so the pad continues there and wraps around.
+	vector<uint8_t> assembled(size + 1, 0xEE);
+	for (int i = 0; i < pageCount; ++i)
+	{
+		int offset = ((i + 3) % pageCount) * ConfigDumpReport::PAGE_SIZE;
+		CHECK(PlaceConfigDumpPage(Page(configuration, offset), size, assembled.data()));
+	}
+
+	CHECK(equal(configuration.begin(), configuration.end(), assembled.begin()));
+
+	// The last page is partly filled, nothing is copied beyond the configuration.
+	CHECK_EQUAL(0xEE, assembled[size]);
+}
+
+TEST(ConfigDumpRejectsUnexpectedOffsets)
+{
+	auto configuration = SampleConfiguration();
+	int size = (int)configuration.size();
+	vector<uint8_t> assembled(size);
+
+	CHECK(!PlaceConfigDumpPage(Page(configuration, ConfigDumpReport::PAGE_SIZE / 2), size, assembled.data()));
+
+	auto beyond = Page(configuration, 0);
+	int offset = ((size + ConfigDumpReport::PAGE_SIZE - 1) / ConfigDumpReport::PAGE_SIZE) * ConfigDumpReport::PAGE_SIZE;
+	beyond.offset.bytes[0] = offset & 0xFF;
+	beyond.offset.bytes[1] = offset >> 8;
+	CHECK(!PlaceConfigDumpPage(beyond, size, assembled.data()));
+}
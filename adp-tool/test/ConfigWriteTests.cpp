@@ -0,0 +1,121 @@
+#include <cstddef>
+#include <cstring>
+#include <map>
+#include <vector>
+
+#include "Model/Protocol.h"
+#include "Test.h"
+
+using namespace std;
+using namespace adp;
+
+typedef map<int, vector<uint8_t>> ConfigWrites;
+
+// Reads the records back from the reports, the way the pad does.
+static ConfigWrites ReadRecords(const vector<ConfigWriteTransaction>& transactions)
+{
+	ConfigWrites writes;
+
+	for (auto& transaction : transactions)
+	{
+		for (auto& report : transaction)
+		{
+			int position = 0;
+			while (position < report.size)
+			{
+				ConfigWriteReport::Record record;
+				memcpy(&record, report.records + position, sizeof(record));
+				position += sizeof(record);
+
+				int offset = record.offset.bytes[0] | record.offset.bytes[1] << 8;
+				writes[offset].assign(report.records + position, report.records + position + record.length);
+				position += record.length;
+			}
+			CHECK_EQUAL(report.size, position);
+		}
+	}
+
+	return writes;
+}
+
+static int TransactionSize(const ConfigWriteTransaction& transaction)
+{
+	int size = 0;
+	for (auto& report : transaction)
+		size += report.size;
+	return size;
+}
+
+// Writes of every sensor, like a profile that changes all thresholds.
+static ConfigWrites SensorWrites()
+{
+	ConfigWrites writes;
+	for (int i = 0; i < MAX_SENSOR_COUNT; ++i)
+	{
+		int offset = offsetof(ConfigurationV1, sensors) + i * (int)sizeof(ConfigurationV1::Sensor);
+		for (int b = 0; b < (int)sizeof(ConfigurationV1::Sensor); ++b)
+			writes[offset].push_back((uint8_t)(i * 16 + b));
+	}
+	return writes;
+}
+
+TEST(BatchNothing)
+{
+	CHECK(BatchConfigWrites({}).empty());
+}
+
+TEST(BatchSingleWrite)
+{
+	ConfigWrites writes = { { 0x123, { 1, 2, 3 } } };
+	auto transactions = BatchConfigWrites(writes);
+
+	CHECK_EQUAL(1u, transactions.size());
+	CHECK_EQUAL(1u, transactions[0].size());
+
+	auto& report = transactions[0][0];
+	CHECK_EQUAL(REPORT_CONFIG_WRITE, report.reportId);
+	CHECK_EQUAL(6, report.size);
+	CHECK_EQUAL(0x23, report.records[0]);
+	CHECK_EQUAL(0x01, report.records[1]);
+	CHECK_EQUAL(3, report.records[2]);
+	CHECK_EQUAL(3, report.records[5]);
+}
+
+TEST(BatchFillsReportsBeforeStartingAnother)
+{
+	auto writes = SensorWrites();
+	auto transactions = BatchConfigWrites(writes);
+	int recordSize = sizeof(ConfigWriteReport::Record) + sizeof(ConfigurationV1::Sensor);
+
+	CHECK(ReadRecords(transactions) == writes);
+
+	for (auto& transaction : transactions)
+	{
+		for (size_t i = 0; i < transaction.size(); ++i)
+		{
+			CHECK(transaction[i].size <= ConfigWriteReport::RECORDS_SIZE);
+			if (i + 1 < transaction.size())
+				CHECK(transaction[i].size + recordSize > ConfigWriteReport::RECORDS_SIZE);
+		}
+	}
+}
+
+TEST(BatchSplitsTransactionsThePadCanNotHold)
+{
+	auto writes = SensorWrites();
+	for (int i = 0; i < MAX_LED_MAPPINGS; ++i)
+	{
+		int offset = offsetof(ConfigurationV1, ledMappings) + i * (int)sizeof(ConfigurationV1::LedMapping);
+		writes[offset].assign(sizeof(ConfigurationV1::LedMapping), (uint8_t)i);
+	}
+
+	auto transactions = BatchConfigWrites(writes);
+	CHECK(transactions.size() > 1);
+	CHECK(ReadRecords(transactions) == writes);
+
+	for (auto& transaction : transactions)
+	{
+		CHECK(!transaction.empty());
+		CHECK(TransactionSize(transaction) <= ConfigWriteReport::TRANSACTION_SIZE);
+	}
+}
@@ -0,0 +1,96 @@
+#include <string>
+#include <vector>
+
+#include "Model/Protocol.h"
+#include "Test.h"
+
+using namespace std;
+using namespace adp;
+
+static void AppendText(vector<uint8_t>& bytes, const string& text)
+{
+	bytes.push_back(DEBUG_RECORD_TEXT);
+	bytes.push_back((uint8_t)text.size());
+	bytes.insert(bytes.end(), text.begin(), text.end());
+}
+
+// Event, two arguments and the time, little endian like the pad sends them.
+static void AppendTrace(vector<uint8_t>& bytes, int event, int arg0, int arg1, uint32_t time)
+{
+	bytes.insert(bytes.end(), {
+		DEBUG_RECORD_TRACE, (uint8_t)event,
+		(uint8_t)arg0, (uint8_t)(arg0 >> 8),
+		(uint8_t)arg1, (uint8_t)(arg1 >> 8),
+		(uint8_t)time, (uint8_t)(time >> 8), (uint8_t)(time >> 16), (uint8_t)(time >> 24) });
+}
+
+TEST(DecodeTextAndTraceRecords)
+{
+	vector<uint8_t> bytes;
+	AppendText(bytes, "hello ");
+	AppendTrace(bytes, DebugTraceRecord::CONFIG_BANK_SELECTED, 3, 0x1234, 0x01020304);
+	AppendText(bytes, "pad");
+
+	auto decoded = DecodeDebugRecords(bytes.data(), bytes.size());
+	CHECK(decoded.text == "hello pad");
+	CHECK_EQUAL(bytes.size(), decoded.size);
+	CHECK_EQUAL(-1, decoded.unknownType);
+	CHECK_EQUAL(1u, decoded.traces.size());
+
+	auto& trace = decoded.traces[0];
+	CHECK_EQUAL((int)DebugTraceRecord::CONFIG_BANK_SELECTED, trace.event);
+	CHECK_EQUAL(3, trace.args[0].bytes[0] | trace.args[0].bytes[1] << 8);
+	CHECK_EQUAL(0x1234, trace.args[1].bytes[0] | trace.args[1].bytes[1] << 8);
+	CHECK_EQUAL(0x04, trace.time.bytes[0]);
+	CHECK_EQUAL(0x01, trace.time.bytes[3]);
+}
+
+TEST(DecodeKeepsSplitTextRecord)
+{
+	vector<uint8_t> bytes;
+	AppendText(bytes, "first");
+	size_t firstSize = bytes.size();
+	AppendText(bytes, "second");
+
+	// Only the header of the second record arrived.
+	auto decoded = DecodeDebugRecords(bytes.data(), firstSize + 2);
+	CHECK(decoded.text == "first");
+	CHECK_EQUAL(firstSize, decoded.size);
+
+	// Part of its text arrived.
+	decoded = DecodeDebugRecords(bytes.data() + firstSize, 5);
+	CHECK(decoded.text.empty());
+	CHECK_EQUAL(0u, decoded.size);
+
+	// The rest arrived.
+	decoded = DecodeDebugRecords(bytes.data() + firstSize, bytes.size() - firstSize);
+	CHECK(decoded.text == "second");
+	CHECK_EQUAL(bytes.size() - firstSize, decoded.size);
+}
+
+TEST(DecodeKeepsSplitTraceRecord)
+{
+	vector<uint8_t> bytes;
+	AppendTrace(bytes, DebugTraceRecord::DROPPED, 7, 0, 100);
+
+	auto decoded = DecodeDebugRecords(bytes.data(), bytes.size() - 1);
+	CHECK(decoded.traces.empty());
+	CHECK_EQUAL(0u, decoded.size);
+
+	decoded = DecodeDebugRecords(bytes.data(), bytes.size());
+	CHECK_EQUAL(1u, decoded.traces.size());
+	CHECK_EQUAL(sizeof(DebugTraceRecord), decoded.size);
+}
+
+TEST(DecodeSkipsEverythingAfterUnknownRecord)
+{
+	vector<uint8_t> bytes;
+	AppendText(bytes, "kept");
+	bytes.push_back(0x7F);
+	AppendText(bytes, "lost");
+
+	auto decoded = DecodeDebugRecords(bytes.data(), bytes.size());
+	CHECK(decoded.text == "kept");
+	CHECK_EQUAL(0x7F, decoded.unknownType);
+	CHECK_EQUAL(bytes.size(), decoded.size);
+}
@@ -0,0 +1,36 @@
+#include <cstdio>
+
+#include "Test.h"
+
+namespace adp {
+namespace test {
+
+int failures = 0;
+
+std::vector<TestCase>& TestCases()
+{
+	static std::vector<TestCase> testCases;
+	return testCases;
+}
+
+}; // namespace test.
+}; // namespace adp.
+
+using namespace adp::test;
+
+int main()
+{
+	int failedTests = 0;
+
+	for (auto& testCase : TestCases())
+	{
+		failures = 0;
+		testCase.run();
+		std::printf("%s %s\n", failures == 0 ? "PASS" : "FAIL", testCase.name);
+		if (failures > 0)
+			++failedTests;
+	}
+
+	std::printf("%i of %i tests failed\n", failedTests, (int)TestCases().size());
+	return failedTests == 0 ? 0 : 1;
+}
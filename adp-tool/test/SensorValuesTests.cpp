@@ -0,0 +1,147 @@
+#include <vector>
+
+#include "Model/Protocol.h"
+#include "Test.h"
+
+using namespace std;
+using namespace adp;
+
+// Packs values the way the pad does, COMPACT_SENSOR_BITS each starting at the lowest bit, one for every bit in sensorMask.
+static vector<uint8_t> PackSensorValues(const int* values, int sensorMask)
+{
+	vector<uint8_t> packed;
+	int bit = 0;
+
+	for (int i = 0; i < MAX_SENSOR_COUNT; ++i)
+	{
+		if (!(sensorMask & (1 << i)))
+			continue;
+
+		packed.resize((bit + COMPACT_SENSOR_BITS + 7) / 8);
+		for (int b = 0; b < COMPACT_SENSOR_BITS; ++b, ++bit)
+		{
+			if (values[i] & (1 << b))
+				packed[bit / 8] |= 1 << (bit % 8);
+		}
+	}
+
+	return packed;
+}
+
+static int Value(uint16_le value)
+{
+	return value.bytes[0] | value.bytes[1] << 8;
+}
+
+// Report id, button bits, sensor mask, then the packed groups and optionally a trailer.
+static vector<uint8_t> CompactReport(int reportId, int sensorMask, const vector<vector<uint8_t>>& groups, bool trailer)
+{
+	vector<uint8_t> report = { (uint8_t)reportId, 0x01, 0x80, (uint8_t)(sensorMask & 0xFF), (uint8_t)(sensorMask >> 8) };
+
+	for (auto& group : groups)
+		report.insert(report.end(), group.begin(), group.end());
+
+	if (trailer)
+		report.insert(report.end(), { 42, 0x2C, 0x01, InputReportTrailer::DEBUG_PENDING });
+
+	return report;
+}
+
+TEST(UnpackSensorValuesOfWiredSensors)
+{
+	const int values[MAX_SENSOR_COUNT] = { 0, 1023, 512, 37 };
+	auto packed = PackSensorValues(values, 0x00F);
+
+	uint16_le unpacked[MAX_SENSOR_COUNT];
+	CHECK_EQUAL(5, UnpackSensorValues(packed.data(), (int)packed.size(), 0x00F, unpacked));
+
+	for (int i = 0; i < MAX_SENSOR_COUNT; ++i)
+		CHECK_EQUAL(values[i], Value(unpacked[i]));
+}
+
+TEST(UnpackSensorValuesPlacesSparseSensorsByMask)
+{
+	int values[MAX_SENSOR_COUNT] = {};
+	values[2] = 700;
+	values[7] = 5;
+	values[11] = 1000;
+	auto packed = PackSensorValues(values, 0x884);
+
+	uint16_le unpacked[MAX_SENSOR_COUNT];
+	CHECK_EQUAL(4, UnpackSensorValues(packed.data(), (int)packed.size(), 0x884, unpacked));
+
+	for (int i = 0; i < MAX_SENSOR_COUNT; ++i)
+		CHECK_EQUAL(values[i], Value(unpacked[i]));
+}
+
+TEST(UnpackSensorValuesRejectsShortGroup)
+{
+	const int values[MAX_SENSOR_COUNT] = { 1, 2, 3, 4 };
+	auto packed = PackSensorValues(values, 0x00F);
+
+	uint16_le unpacked[MAX_SENSOR_COUNT];
+	CHECK_EQUAL(-1, UnpackSensorValues(packed.data(), (int)packed.size() - 1, 0x00F, unpacked));
+}
+
+TEST(DecodeCompactReportWithTrailer)
+{
+	int values[MAX_SENSOR_COUNT] = {};
+	for (int i = 0; i < 8; ++i)
+		values[i] = 100 * i + 3;
+	auto buffer = CompactReport(REPORT_COMPACT_SENSOR_VALUES, 0x0FF, { PackSensorValues(values, 0x0FF) }, true);
+
+	SensorValuesReport report;
+	CHECK(DecodeCompactSensorValues(buffer.data(), (int)buffer.size(), report));
+	CHECK_EQUAL(0x8001, Value(report.buttonBits));
+	CHECK(!report.hasExtremes);
+	CHECK(report.hasTrailer);
+	CHECK_EQUAL(42, report.trailer.sequence);
+	CHECK_EQUAL(300, Value(report.trailer.sampleAge));
+	CHECK_EQUAL((int)InputReportTrailer::DEBUG_PENDING, report.trailer.flags);
+
+	for (int i = 0; i < MAX_SENSOR_COUNT; ++i)
+		CHECK_EQUAL(values[i], Value(report.sensorValues[i]));
+}
+
+TEST(DecodeCompactReportWithoutTrailer)
+{
+	const int values[MAX_SENSOR_COUNT] = { 9, 99, 999, 1 };
+	auto buffer = CompactReport(REPORT_COMPACT_SENSOR_VALUES, 0x00F, { PackSensorValues(values, 0x00F) }, false);
+
+	SensorValuesReport report;
+	CHECK(DecodeCompactSensorValues(buffer.data(), (int)buffer.size(), report));
+	CHECK(!report.hasTrailer);
+	CHECK_EQUAL(999, Value(report.sensorValues[2]));
+}
+
+TEST(DecodeExtremesReport)
+{
+	const int values[MAX_SENSOR_COUNT] = { 400, 410, 420, 430 };
+	const int peaks[MAX_SENSOR_COUNT] = { 900, 910, 920, 930 };
+	const int troughs[MAX_SENSOR_COUNT] = { 10, 11, 12, 13 };
+	auto buffer = CompactReport(REPORT_EXTREMES_SENSOR_VALUES, 0x00F,
+		{ PackSensorValues(values, 0x00F), PackSensorValues(peaks, 0x00F), PackSensorValues(troughs, 0x00F) }, true);
+
+	SensorValuesReport report;
+	CHECK(DecodeCompactSensorValues(buffer.data(), (int)buffer.size(), report));
+	CHECK(report.hasExtremes);
+	CHECK(report.hasTrailer);
+	CHECK_EQUAL(42, report.trailer.sequence);
+
+	for (int i = 0; i < 4; ++i)
+	{
+		CHECK_EQUAL(values[i], Value(report.sensorValues[i]));
+		CHECK_EQUAL(peaks[i], Value(report.sensorPeaks[i]));
+		CHECK_EQUAL(troughs[i], Value(report.sensorTroughs[i]));
+	}
+}
+
+TEST(DecodeExtremesReportRejectsMissingTroughs)
+{
+	const int values[MAX_SENSOR_COUNT] = { 400, 410, 420, 430 };
+	auto buffer = CompactReport(REPORT_EXTREMES_SENSOR_VALUES, 0x00F,
+		{ PackSensorValues(values, 0x00F), PackSensorValues(values, 0x00F) }, false);
+
+	SensorValuesReport report;
+	CHECK(!DecodeCompactSensorValues(buffer.data(), (int)buffer.size(), report));
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstdio>
+#include <vector>
+
+// A minimal test runner, so the tests build without any libraries besides the tool sources they cover.
+
+namespace adp {
+namespace test {
+
+struct TestCase
+{
+	const char* name;
+	void (*run)();
+};
+
+std::vector<TestCase>& TestCases();
+
+// Failed checks of the test that is running.
+extern int failures;
+
+struct Registration
+{
+	Registration(const char* name, void (*run)()) { TestCases().push_back({ name, run }); }
+};
+
+}; // namespace test.
+}; // namespace adp.
+
+#define TEST(name) \
+	static void name(); \
+	static adp::test::Registration name##Registration(#name, name); \
+	static void name()
+
+#define CHECK(condition) \
+	do { \
+		if (!(condition)) { \
+			std::printf("%s:%i: CHECK(%s) failed\n", __FILE__, __LINE__, #condition); \
+			++adp::test::failures; \
+		} \
+	} while (0)
+
+#define CHECK_EQUAL(expected, actual) \
+	do { \
+		auto expectedValue = (expected); \
+		auto actualValue = (actual); \
+		if (!(expectedValue == actualValue)) { \
+			std::printf("%s:%i: CHECK_EQUAL(%s, %s) failed, got %lld\n", __FILE__, __LINE__, #expected, #actual, (long long)actualValue); \
+			++adp::test::failures; \
+		} \
+	} while (0)
@@ -1,9 +1,14 @@
 #include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
 #include <avr/io.h>
+#include <avr/interrupt.h>
+#include <util/atomic.h>
 
 #include "Config/DancePadConfig.h"
-#include "Pad.h"
+#include "ConfigStore.h"
 #include "ADC.h"
+#include "Timer.h"
 
 // see page 308 of https://cdn.sparkfun.com/datasheets/Dev/Arduino/Boards/ATMega32U4.pdf for these
 static const uint8_t sensorToAnalogPin[SENSOR_COUNT] = {
@@ -50,69 +55,164 @@ static const uint8_t sensorToAnalogPin[SENSOR_COUNT] = {
 #endif
 };
 
-void ADC_LoadPot(uint8_t sensor) {
-	SensorConfig s = PAD_CONF.sensors[sensor];
-	
-	// PD1 PD0 PC6 PE6
-	
-	// Set the correct muxer output
-	
-	if(sensor & 1) {
-		PORTD |= 1 << DDD1;
-	}
-	else {
-		PORTD &= ~(1 << DDD1);
-	}
-	
-	if(sensor & (1 << 1)) {
-		PORTD |= 1 << DDD0;
-	}
-	else {
-		PORTD &= ~(1 << DDD0);
-	}
+// a new scan is started on every timer0 compare match where the previous scan has finished.
+// timer0 runs at F_CPU / 64, so one tick is 4us at 16MHz. 125 ticks = 500us between scan starts.
+#define SCAN_INTERVAL_TICKS 125
+
+// marks that no scan is currently in progress
+#define SCAN_IDLE 0xFF
+
+// sensors converted during a scan, in order. a new list set by ADC_SetScanList
+// is only taken over when the next scan starts.
+static uint8_t scanList[SENSOR_COUNT];
+static uint8_t scanListLength = 0;
+static uint8_t pendingScanList[SENSOR_COUNT];
+static uint8_t pendingScanListLength = 0;
+static volatile bool scanListChanged = false;
+
+// one buffer is filled by the conversion interrupt while the other holds the latest completed scan
+static volatile uint16_t scanBuffers[2][SENSOR_COUNT];
+static volatile uint16_t scanMinimums[2][SENSOR_COUNT];
+static volatile uint16_t scanMaximums[2][SENSOR_COUNT];
+static volatile uint8_t scanWriteBuffer = 0;
+static volatile uint8_t scanIndex = SCAN_IDLE;
+static volatile bool scanAvailable = false;
+static volatile uint32_t scanTime = 0;
+
+// number of completed scans, used to schedule sensors with a rate divisor
+static uint8_t scanCount = 0;
+
+// conversions of the current sensor, which is converted repeatedly when it is oversampled
+static uint8_t sampleCount = 0;
+static uint16_t sampleSum;
+static uint16_t sampleMinimum;
+static uint16_t sampleMaximum;
+
+#if defined(FEATURE_DIGIPOT_ENABLED)
+// there is a single digipot, which the muxer connects to the sensor being converted. it holds the
+// wiper of one sensor at a time, so there is no wiper per sensor that could be cached. instead the pot
+// is only written when a sensor needs another resistor value than the one written last, which never
+// happens when all sensors use the same value. the muxer is switched for every sensor.
+static uint8_t potSensor = SCAN_IDLE;
+static int16_t potResistorValue = -1;
+// when the muxer or pot last changed. conversions wait until DIGIPOT_SETTLE_TIME_US after it.
+static uint32_t potLoadTime = 0;
+// bytes of the spi transfer to the pot that are not sent yet
+static uint8_t potTransferLeft = 0;
+
+// the adc samples its input during the first 1.5 adc clock cycles of a conversion, 6us at
+// F_CPU / 64. after that the muxer and pot can be switched without affecting the result.
+#define ADC_SAMPLE_HOLD_US 8
+
+// converts microseconds into a number of timer0 ticks to wait with ADC_SchedulePotEvent
+#define SCAN_TICKS(us) ((us) / (64000000UL / F_CPU) + 2)
+
+// what timer0 compare B does when it fires. the interrupts never wait for the muxer or pot,
+// they schedule one of these instead, so other interrupts are only held off for a few cycles.
+#define POT_EVENT_PREPARE 0 // set up the next sensor, once the current conversion sampled its input
+#define POT_EVENT_START   1 // start the conversion of the current sensor, once its pot settled
+static uint8_t potEvent;
+
+// Has timer0 compare B run the event after more than ticks - 1 timer0 ticks. Only called with interrupts disabled.
+static void ADC_SchedulePotEvent(uint8_t event, uint8_t ticks) {
+    uint8_t compare = TCNT0 + ticks;
+    if (compare >= SCAN_INTERVAL_TICKS) {
+        compare -= SCAN_INTERVAL_TICKS;
+    }
+
+    potEvent = event;
+    OCR0B = compare;
+    TIFR0 = (1 << OCF0B);
+    TIMSK0 |= (1 << OCIE0B);
+}
+
+// Switches the muxer to the sensor, and starts writing its resistor value to the pot if that changed.
+// The spi transfer runs in the background, a pot that is still busy is written on a later call.
+static void ADC_LoadPot(uint8_t sensor) {
+	uint8_t resistorValue = PAD_CONF.sensors[sensor].resistorValue;
 	
-	if(sensor & (1 << 2)) {
-		PORTC |= 1 << DDC6;
-	}
-	else {
-		PORTC &= ~(1 << DDC6);
+	if (sensor != potSensor) {
+		// PD1 PD0 PC6 PE6
+		
+		// Set the correct muxer output
+		
+		if(sensor & 1) {
+			PORTD |= 1 << DDD1;
+		}
+		else {
+			PORTD &= ~(1 << DDD1);
+		}
+		
+		if(sensor & (1 << 1)) {
+			PORTD |= 1 << DDD0;
+		}
+		else {
+			PORTD &= ~(1 << DDD0);
+		}
+		
+		if(sensor & (1 << 2)) {
+			PORTC |= 1 << DDC6;
+		}
+		else {
+			PORTC &= ~(1 << DDC6);
+		}
+		
+		if(sensor & (1 << 3)) {
+			PORTE |= 1 << DDE6;
+		}
+		else {
+			PORTE &= ~(1 << DDE6);
+		}
+		
+		potSensor = sensor;
+		potLoadTime = Timer_Micros();
 	}
 	
-	if(sensor & (1 << 3)) {
-		PORTE |= 1 << DDE6;
+	if (resistorValue != potResistorValue && potTransferLeft == 0) {
+		// Set the digipot via SPI, the transfer complete interrupt sends the rest
+		
+		// on FSRIO_1 the light pin is on the SPI register, so SPI is only enabled during the transfer
+		SPCR = (1 << SPIE) | (1 << SPE) | (1 << MSTR);  // SPI enable, Master, interrupt
+		
+		PORTB &= ~(1 << DDB6);
+		
+		potResistorValue = resistorValue;
+		potTransferLeft = 2;
+		SPDR = 0b00010001;
 	}
-	else {
-		PORTE &= ~(1 << DDE6);
+}
+
+ISR(SPI_STC_vect) {
+	if (--potTransferLeft > 0) {
+		SPDR = (uint8_t) potResistorValue;
+		return;
 	}
 	
-	// Set the digipot via SPI
-	
-	#if defined(BOARD_TYPE_FSRIO_1)
-		// Light pin is on the SPI register. Need to enable/disable SPI each time.
-		SPCR = (1 << SPE) | (1 << MSTR);  // SPI enable, Master
-	#endif
-	
-	PORTB &= ~(1 << DDB6);
-	
-	SPDR = 0b00010001;
-    while(! (SPSR & (1 << SPIF)) ) ;
-	
-	SPDR = s.resistorValue;	
-    while(! (SPSR & (1 << SPIF)) ) ;
-	
 	PORTB |= 1 << DDB6;
 	
 	#if defined(BOARD_TYPE_FSRIO_1)
-		// Light pin is on the SPI register. Need to enable/disable SPI each time.
 		SPCR = 0;
+	#else
+		SPCR = (1 << SPE) | (1 << MSTR);
 	#endif
+	
+	potLoadTime = Timer_Micros();
+}
+
+// Returns true when the muxer and pot are set up for the sensor and had time to settle.
+static bool ADC_IsPotReady(uint8_t sensor) {
+	return sensor == potSensor
+		&& potTransferLeft == 0
+		&& PAD_CONF.sensors[sensor].resistorValue == potResistorValue
+		&& Timer_Micros() - potLoadTime >= DIGIPOT_SETTLE_TIME_US;
 }
+#endif
 
 void ADC_Init(void) {
     // different prescalers change conversion speed. tinker! 111 is slowest, and not fast enough for many sensors.
     const uint8_t prescaler = (1 << ADPS2) | (1 << ADPS1) | (0 << ADPS0);
 
-    ADCSRA = (1 << ADEN) | prescaler;
+    ADCSRA = (1 << ADEN) | (1 << ADIE) | prescaler;
     ADMUX = (1 << REFS0);
     ADCSRB = (1 << ADHSM); // enable high speed mode
 
@@ -123,26 +223,204 @@ void ADC_Init(void) {
 	
 	#if defined(FEATURE_DIGIPOT_ENABLED)
 		DDRB |= (1 << DDB6) | (1 << DDB2) | (1 << DDB1); //spi pins on port b SS, MOSI, SCK outputs
-		SPCR = (1 << SPE) | (1 << MSTR);  // SPI enable, Master
+		PORTB |= 1 << DDB6;
+		
+		#if !defined(BOARD_TYPE_FSRIO_1)
+			SPCR = (1 << SPE) | (1 << MSTR);  // SPI enable, Master
+		#endif
 	#endif
+
+    // timer0 in CTC mode with prescaler 64 triggers the scans
+    TCCR0A = (1 << WGM01);
+    TCCR0B = (1 << CS01) | (1 << CS00);
+    OCR0A = SCAN_INTERVAL_TICKS - 1;
+    TIMSK0 = (1 << OCIE0A);
 }
 
-uint16_t ADC_Read(uint8_t sensor) {
-    uint8_t pin = sensorToAnalogPin[sensor];
-	if(pin == 0b111111) {
-		return 0;
-	}
-	
+bool ADC_IsSensorWired(uint8_t sensor) {
+    return sensorToAnalogPin[sensor] != 0b111111;
+}
+
+void ADC_SetScanList(const uint8_t* sensors, uint8_t count) {
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        memcpy(pendingScanList, sensors, count);
+        pendingScanListLength = count;
+        scanListChanged = true;
+    }
+}
+
+// Only called with interrupts disabled, between scans.
+static void ADC_ApplyScanList(void) {
+    memcpy(scanList, pendingScanList, pendingScanListLength);
+    scanListLength = pendingScanListLength;
+    scanListChanged = false;
+
+    // sensors that are no longer scanned read as zero, so they can't keep a button pressed
+    for (uint8_t sensor = 0; sensor < SENSOR_COUNT; sensor++) {
+        if (memchr(scanList, sensor, scanListLength) == NULL) {
+            scanBuffers[0][sensor] = scanBuffers[1][sensor] = 0;
+            scanMinimums[0][sensor] = scanMinimums[1][sensor] = 0;
+            scanMaximums[0][sensor] = scanMaximums[1][sensor] = 0;
+        }
+    }
+}
+
+// Sensors with a rate divisor of 1 << n are converted every 1 << n scans. The position in the
+// scan list offsets the schedule, so sensors with the same divisor are spread over different scans.
+static bool ADC_IsSensorDue(uint8_t index) {
+    uint8_t shift = (PAD_CONF.sensors[scanList[index]].sampling & SAMPLING_RATE_DIVISOR_MASK) >> SAMPLING_RATE_DIVISOR_SHIFT;
+    if (shift > MAX_RATE_DIVISOR_SHIFT) {
+        shift = MAX_RATE_DIVISOR_SHIFT;
+    }
+
+    return ((uint8_t)(scanCount + index) & ((1 << shift) - 1)) == 0;
+}
+
+static uint8_t ADC_OversamplingShift(uint8_t sensor) {
+    uint8_t shift = PAD_CONF.sensors[sensor].sampling & SAMPLING_OVERSAMPLING_MASK;
+    return shift > MAX_OVERSAMPLING_SHIFT ? MAX_OVERSAMPLING_SHIFT : shift;
+}
+
+// Starts the conversion of the sensor at scanIndex. On digipot boards a sensor whose muxer and pot are not
+// set up yet, or still settling, is set up and its conversion started later by timer0 compare B.
+// Only called with interrupts disabled.
+static void ADC_ConvertSensor(void) {
+    uint8_t sensor = scanList[scanIndex];
+
 	#if defined(FEATURE_DIGIPOT_ENABLED)
-		ADC_LoadPot(sensor);
+		// usually the sensor was already set up during the previous conversion and has settled
+		if (!ADC_IsPotReady(sensor)) {
+			ADC_LoadPot(sensor);
+			ADC_SchedulePotEvent(POT_EVENT_START, SCAN_TICKS(DIGIPOT_SETTLE_TIME_US));
+			return;
+		}
 	#endif
 
+    uint8_t pin = sensorToAnalogPin[sensor];
+
     // see: https://www.avrfreaks.net/comment/885267#comment-885267
     ADMUX = (ADMUX & 0xE0) | (pin & 0x1F);   //select channel (MUX0-4 bits)
 	ADCSRB = (ADCSRB & 0xDF) | (pin & 0x20);   //select channel (MUX5 bit) 
 	
 	ADCSRA |= (1 << ADSC); // start conversion
-	while (ADCSRA & (1 << ADSC)) {}; // wait until done
-		
-    return ADC;
+
+	#if defined(FEATURE_DIGIPOT_ENABLED)
+		if (ADC_OversamplingShift(sensor) == 0) {
+			ADC_SchedulePotEvent(POT_EVENT_PREPARE, SCAN_TICKS(ADC_SAMPLE_HOLD_US));
+		}
+	#endif
+}
+
+// Starts a conversion for the first sensor due at or after the given position in the scan list.
+// When the list is done, the scan is complete and gets published. Only called with interrupts disabled.
+static void ADC_StartConversion(uint8_t index) {
+    // sensors which are skipped in this scan keep their value from the previous one
+    while (index < scanListLength && !ADC_IsSensorDue(index)) {
+        uint8_t sensor = scanList[index];
+        scanBuffers[scanWriteBuffer][sensor] = scanBuffers[scanWriteBuffer ^ 1][sensor];
+        scanMinimums[scanWriteBuffer][sensor] = scanMinimums[scanWriteBuffer ^ 1][sensor];
+        scanMaximums[scanWriteBuffer][sensor] = scanMaximums[scanWriteBuffer ^ 1][sensor];
+        index++;
+    }
+
+    if (index >= scanListLength) {
+        scanIndex = SCAN_IDLE;
+        scanTime = Timer_Micros();
+        scanWriteBuffer ^= 1;
+        scanCount++;
+        scanAvailable = true;
+        return;
+    }
+
+    scanIndex = index;
+    ADC_ConvertSensor();
+}
+
+#if defined(FEATURE_DIGIPOT_ENABLED)
+ISR(TIMER0_COMPB_vect) {
+    TIMSK0 &= ~(1 << OCIE0B);
+
+    if (scanIndex == SCAN_IDLE) {
+        return;
+    }
+
+    if (potEvent == POT_EVENT_START) {
+        ADC_ConvertSensor();
+        return;
+    }
+
+    // the last conversion of the current sensor sampled its input, set up the next sensor
+    // of the scan while it runs, which also gives the pot time to settle
+    uint8_t index = scanIndex + 1;
+    while (index < scanListLength && !ADC_IsSensorDue(index)) {
+        index++;
+    }
+
+    if (index < scanListLength) {
+        ADC_LoadPot(scanList[index]);
+    }
+}
+#endif
+
+ISR(TIMER0_COMPA_vect) {
+    if (scanIndex == SCAN_IDLE) {
+        if (scanListChanged) {
+            ADC_ApplyScanList();
+        }
+
+        ADC_StartConversion(0);
+    }
+}
+
+ISR(ADC_vect) {
+    uint16_t value = ADC;
+    uint8_t sensor = scanList[scanIndex];
+
+    if (sampleCount == 0) {
+        sampleSum = sampleMinimum = sampleMaximum = value;
+    } else {
+        sampleSum += value;
+        if (value < sampleMinimum) sampleMinimum = value;
+        if (value > sampleMaximum) sampleMaximum = value;
+    }
+
+    uint8_t shift = ADC_OversamplingShift(sensor);
+
+    // the channel is still selected, so further conversions can start right away
+    if (++sampleCount < (1 << shift)) {
+        ADCSRA |= (1 << ADSC);
+
+        #if defined(FEATURE_DIGIPOT_ENABLED)
+            if (sampleCount == (1 << shift) - 1) {
+                ADC_SchedulePotEvent(POT_EVENT_PREPARE, SCAN_TICKS(ADC_SAMPLE_HOLD_US));
+            }
+        #endif
+
+        return;
+    }
+
+    scanBuffers[scanWriteBuffer][sensor] = sampleSum >> shift;
+    scanMinimums[scanWriteBuffer][sensor] = sampleMinimum;
+    scanMaximums[scanWriteBuffer][sensor] = sampleMaximum;
+    sampleCount = 0;
+
+    ADC_StartConversion(scanIndex + 1);
+}
+
+bool ADC_ReadScan(uint16_t* values, uint16_t* minimums, uint16_t* maximums, uint32_t* time) {
+    bool available;
+
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        available = scanAvailable;
+
+        if (available) {
+            memcpy(values, (const uint16_t*) scanBuffers[scanWriteBuffer ^ 1], sizeof (uint16_t) * SENSOR_COUNT);
+            memcpy(minimums, (const uint16_t*) scanMinimums[scanWriteBuffer ^ 1], sizeof (uint16_t) * SENSOR_COUNT);
+            memcpy(maximums, (const uint16_t*) scanMaximums[scanWriteBuffer ^ 1], sizeof (uint16_t) * SENSOR_COUNT);
+            *time = scanTime;
+            scanAvailable = false;
+        }
+    }
+
+    return available;
 }
@@ -1,7 +1,18 @@
 #ifndef _ADC_H_
 #define _ADC_H_
     #include <stdint.h>
+    #include <stdbool.h>
     
     void ADC_Init(void);
-    uint16_t ADC_Read(uint8_t channel);
+    bool ADC_IsSensorWired(uint8_t sensor);
+
+    // Sets the sensors converted during a scan, in order, starting with the next scan.
+    // Sensors not in the list read as zero.
+    void ADC_SetScanList(const uint8_t* sensors, uint8_t count);
+
+    // Copies the latest completed scan into values, minimums and maximums (SENSOR_COUNT entries each),
+    // and the Timer_Micros timestamp of when it completed into time. Each value is the mean of the
+    // oversampled conversions of that sensor, minimums and maximums the extremes among them.
+    // Returns false, leaving everything untouched, if no new scan completed since the last call.
+    bool ADC_ReadScan(uint16_t* values, uint16_t* minimums, uint16_t* maximums, uint32_t* time);
 #endif
@@ -35,11 +35,7 @@
 #include "Reset.h"
 #include "Lights.h"
 #include "Debug.h"
-
-static Configuration configuration;
-
-/** Buffer to hold the previously generated HID report, for comparison purposes inside the HID class driver. */
-static uint8_t PrevHIDReportBuffer[GENERIC_EPSIZE];
+#include "Timer.h"
 
 /** LUFA HID Class driver interface configuration and state information. This structure is
  *  passed to all HID Class driver functions, so that multiple instances of the same class
@@ -54,13 +50,29 @@ USB_ClassInfo_HID_Device_t Generic_HID_Interface =
                     {
                         .Address              = GENERIC_IN_EPADDR,
                         .Size                 = GENERIC_EPSIZE,
-                        .Banks                = 1,
+                        .Banks                = 2,
                     },
-                .PrevReportINBuffer           = PrevHIDReportBuffer,
-                .PrevReportINBufferSize       = sizeof(PrevHIDReportBuffer),
+                // changes are detected when the input report is built, see Communication_UpdateInputHIDReport
+                .PrevReportINBuffer           = NULL,
+                .PrevReportINBufferSize       = GENERIC_EPSIZE,
             },
     };
 
+// set by RESET_REPORT_ID, the main loop jumps to the bootloader once no store is pending
+static bool resetRequested = false;
+
+// runs the updates for the parts of the configuration that changed, see ConfigStore_Write
+static void ApplyConfigurationChanges(uint8_t changes)
+{
+    if (changes & CONFIG_CHANGED_PAD) {
+        Pad_UpdateConfiguration();
+    }
+
+    if (changes & CONFIG_CHANGED_LIGHTS) {
+        Lights_UpdateConfiguration();
+    }
+}
+
 /** Main program entry point. This routine contains the overall program flow, including initial
  *  setup of all components and the main program loop.
  */
@@ -68,11 +80,24 @@ int main(void)
 {
     SetupHardware();
     GlobalInterruptEnable();
-    ConfigStore_LoadConfiguration(&configuration);
+    ConfigStore_LoadConfiguration(&CONFIGURATION);
     SetupConfiguration();
 
     for (;;)
     {
+        if (Pad_UpdateState())
+        {
+            Communication_UpdateInputHIDReport();
+        }
+
+        Lights_Task();
+        ApplyConfigurationChanges(ConfigStore_Task());
+
+        // the bootloader would not finish a pending store
+        if (resetRequested && !ConfigStore_StorePending()) {
+            Reset_JumpToBootloader();
+        }
+
         HID_Device_USBTask(&Generic_HID_Interface);
         USB_USBTask();
     }
@@ -101,13 +126,18 @@ void SetupHardware(void)
 #endif
 
     /* Hardware Initialization */
+    Timer_Init();
     USB_Init();
 }
 
 void SetupConfiguration()
 {
-	Pad_Initialize(&configuration.padConfiguration);
-    Lights_UpdateConfiguration(&configuration.lightConfiguration);
+	Pad_Initialize();
+    Lights_UpdateConfiguration();
+    Lights_SetFrameRate(LIGHTS_FRAME_RATE);
+
+    // games read the axes input report without adp-tool, so the mode is kept in the configuration
+    Communication_SetInputReportMode(CONFIGURATION.inputReportMode);
 }
 
 /** Event handler for the library USB Configuration Changed event. */
@@ -115,6 +145,9 @@ void EVENT_USB_Device_ConfigurationChanged(void)
 {
     HID_Device_ConfigureEndpoints(&Generic_HID_Interface);
     USB_Device_EnableSOFEvents();
+
+    // a new host session, the previous host may have left without clearing it
+    Pad_SetScanAllSensors(false);
 }
 
 /** Event handler for the library USB Control Request reception event. */
@@ -148,29 +181,28 @@ bool CALLBACK_HID_Device_CreateHIDReport(
 {
     if (*ReportID == 0)
     {
-        // no report id requested - write button and sensor data
-        Communication_WriteInputHIDReport(ReportData);
-        *ReportID = INPUT_REPORT_ID;
-        *ReportSize = sizeof (InputHIDReport);
+        // no report id requested - write button and sensor data, unless nothing changed and no idle report is due
+        bool idlePeriodElapsed = HIDInterfaceInfo->State.IdleCount && !HIDInterfaceInfo->State.IdleMSRemaining;
+        Communication_WriteInputHIDReport(ReportID, ReportData, ReportSize, idlePeriodElapsed);
     }
     else if (*ReportID == PAD_CONFIGURATION_REPORT_ID)
     {
         PadConfigurationFeatureHIDReport* report = ReportData;
 		
 		report->configuration.releaseMultiplier =
-			configuration.padConfiguration.sensors[0].threshold /
-			configuration.padConfiguration.sensors[0].releaseThreshold;
+			CONFIGURATION.padConfiguration.sensors[0].threshold /
+			CONFIGURATION.padConfiguration.sensors[0].releaseThreshold;
 		
 		for (int s = 0; s < SENSOR_COUNT; s++) {
-			report->configuration.sensorThresholds[s] = configuration.padConfiguration.sensors[s].threshold;
-			report->configuration.sensorToButtonMapping[s] = configuration.padConfiguration.sensors[s].buttonMapping;
+			report->configuration.sensorThresholds[s] = CONFIGURATION.padConfiguration.sensors[s].threshold;
+			report->configuration.sensorToButtonMapping[s] = CONFIGURATION.padConfiguration.sensors[s].buttonMapping;
 		}
         *ReportSize = sizeof (PadConfigurationFeatureHIDReport);
     }
     else if (*ReportID == NAME_REPORT_ID)
     {
         NameFeatureHIDReport* report = ReportData;
-        memcpy(&report->nameAndSize, &configuration.nameAndSize, sizeof (report->nameAndSize));
+        memcpy(&report->nameAndSize, &CONFIGURATION.nameAndSize, sizeof (report->nameAndSize));
         *ReportSize = sizeof (NameFeatureHIDReport);
     }
     else if (*ReportID == LIGHT_RULE_REPORT_ID)
@@ -217,26 +249,32 @@ bool CALLBACK_HID_Device_CreateHIDReport(
             memset(&report->sensor, 0, sizeof(SensorConfig));
         *ReportSize = sizeof(SensorHIDReport);
     }
-	#if defined(FEATURE_DEBUG_ENABLED)
+    else if (*ReportID == BUTTON_EVENTS_REPORT_ID)
+    {
+        Communication_WriteButtonEventsReport(ReportData);
+        *ReportSize = sizeof(ButtonEventsHIDReport);
+    }
+    else if (*ReportID == CONFIG_BANKS_REPORT_ID)
+    {
+        Communication_WriteConfigBanksReport(ReportData);
+        *ReportSize = sizeof(ConfigBanksHIDReport);
+    }
+    else if (*ReportID == MEMORY_USAGE_REPORT_ID)
+    {
+        Communication_WriteMemoryUsageReport(ReportData);
+        *ReportSize = sizeof(MemoryUsageHIDReport);
+    }
+    else if (*ReportID == CONFIG_DUMP_REPORT_ID)
+    {
+        Communication_WriteConfigDumpReport(ReportData);
+        *ReportSize = sizeof(ConfigDumpHIDReport);
+    }
 	else if (*ReportID == DEBUG_REPORT_ID)
     {
         DebugHIDReport* report = ReportData;
-		
-		uint16_t readSize = Debug_Available();
-		uint16_t maxReadSize = sizeof(report->messagePacket);
-		
-		if(readSize > 0) {
-			if(readSize > maxReadSize) {
-				readSize = maxReadSize;
-			}
-			
-			report->messageSize = readSize;
-			Debug_ReadBuffer(&report->messagePacket, readSize);
-		}
-		
+		report->messageSize = Debug_ReadBuffer((uint8_t*) report->messagePacket, sizeof(report->messagePacket));
         *ReportSize = sizeof(DebugHIDReport);
     }
-	#endif
 
     return true;
 }
@@ -259,39 +297,39 @@ void CALLBACK_HID_Device_ProcessHIDReport(USB_ClassInfo_HID_Device_t* const HIDI
     {
         const PadConfigurationFeatureHIDReport* report = ReportData;
 		for (int s = 0; s < SENSOR_COUNT; s++) {
-			configuration.padConfiguration.sensors[s].threshold = report->configuration.sensorThresholds[s];
-			configuration.padConfiguration.sensors[s].releaseThreshold = report->configuration.sensorThresholds[s] * report->configuration.releaseMultiplier;
-			configuration.padConfiguration.sensors[s].buttonMapping = report->configuration.sensorToButtonMapping[s];
+			CONFIGURATION.padConfiguration.sensors[s].threshold = report->configuration.sensorThresholds[s];
+			CONFIGURATION.padConfiguration.sensors[s].releaseThreshold = report->configuration.sensorThresholds[s] * report->configuration.releaseMultiplier;
+			CONFIGURATION.padConfiguration.sensors[s].buttonMapping = report->configuration.sensorToButtonMapping[s];
 		}
-        Pad_UpdateConfiguration(&configuration.padConfiguration);
+        Pad_UpdateConfiguration();
     }
     else if (ReportID == RESET_REPORT_ID)
     {
-        Reset_JumpToBootloader();
+        resetRequested = true;
     }
     else if (ReportID == SAVE_CONFIGURATION_REPORT_ID)
     {
-        ConfigStore_StoreConfiguration(&configuration);
+        ConfigStore_StoreConfiguration(&CONFIGURATION);
     }
     else if (ReportID == FACTORY_RESET_REPORT_ID)
     {
-        ConfigStore_FactoryDefaults(&configuration);
-        ConfigStore_StoreConfiguration(&configuration);
+        ConfigStore_FactoryDefaults(&CONFIGURATION);
+        ConfigStore_StoreConfiguration(&CONFIGURATION);
 		SetupConfiguration();
         Reconnect_Usb();
     }
     else if (ReportID == NAME_REPORT_ID && ReportSize == sizeof (NameFeatureHIDReport))
     {
         const NameFeatureHIDReport* report = ReportData;
-        memcpy(&configuration.nameAndSize, &report->nameAndSize, sizeof (configuration.nameAndSize));
+        memcpy(&CONFIGURATION.nameAndSize, &report->nameAndSize, sizeof (CONFIGURATION.nameAndSize));
     }
     else if (ReportID == LIGHT_RULE_REPORT_ID && ReportSize == sizeof (LightRuleHIDReport))
     {
         const LightRuleHIDReport* report = ReportData;
         if (report->index < MAX_LIGHT_RULES)
         {
-            memcpy(&configuration.lightConfiguration.lightRules[report->index], &report->rule, sizeof(LightRule));
-            Lights_UpdateConfiguration(&configuration.lightConfiguration);
+            memcpy(&CONFIGURATION.lightConfiguration.lightRules[report->index], &report->rule, sizeof(LightRule));
+            Lights_UpdateConfiguration();
         }
     }
     else if (ReportID == LED_MAPPING_REPORT_ID && ReportSize == sizeof(LedMappingHIDReport))
@@ -299,23 +337,33 @@ void CALLBACK_HID_Device_ProcessHIDReport(USB_ClassInfo_HID_Device_t* const HIDI
         const LedMappingHIDReport* report = ReportData;
         if (report->index < MAX_LED_MAPPINGS)
         {
-            memcpy(&configuration.lightConfiguration.ledMappings[report->index], &report->mapping, sizeof(LedMapping));
-            Lights_UpdateConfiguration(&configuration.lightConfiguration);
+            memcpy(&CONFIGURATION.lightConfiguration.ledMappings[report->index], &report->mapping, sizeof(LedMapping));
+            Lights_UpdateConfiguration();
         }
     }
+    else if (ReportID == LED_FRAME_REPORT_ID && ReportSize == sizeof(LedFrameHIDReport))
+    {
+        const LedFrameHIDReport* report = ReportData;
+        uint8_t ledCount = report->ledCount < LED_FRAME_REPORT_LEDS ? report->ledCount : LED_FRAME_REPORT_LEDS;
+        Lights_WriteFrame(report->flags, report->ledIndex, ledCount, report->colors);
+    }
     else if (ReportID == SENSOR_REPORT_ID && ReportSize == sizeof(SensorHIDReport))
     {
         const SensorHIDReport* report = ReportData;
         if (report->index < SENSOR_COUNT)
         {
             memcpy(
-				&configuration.padConfiguration.sensors[report->index],
+				&CONFIGURATION.padConfiguration.sensors[report->index],
 				&report->sensor,
 				sizeof(SensorConfig)
 			);
-            Pad_UpdateConfiguration(&configuration.padConfiguration);
+            Pad_UpdateConfiguration();
         }
     }
+    else if (ReportID == CONFIG_WRITE_REPORT_ID && ReportSize == sizeof (ConfigWriteHIDReport))
+    {
+        ApplyConfigurationChanges(Communication_ReadConfigWriteReport(ReportData));
+    }
     else if (ReportID == SET_PROPERTY_REPORT_ID && ReportSize == sizeof (SetPropertyHIDReport))
     {
         const SetPropertyHIDReport* report = ReportData;
@@ -332,6 +380,46 @@ void CALLBACK_HID_Device_ProcessHIDReport(USB_ClassInfo_HID_Device_t* const HIDI
         case SPID_SELECTED_SENSOR_INDEX:
             PAD_CONF.selectedSensorIndex = (uint8_t)report->propertyValue;
             break;
+
+        case SPID_INPUT_REPORT_MODE:
+            Communication_SetInputReportMode((uint8_t)report->propertyValue);
+            break;
+
+        case SPID_INPUT_REPORT_THRESHOLD:
+            Communication_SetInputReportThreshold((uint16_t)report->propertyValue);
+            break;
+
+        case SPID_INPUT_REPORT_IDLE:
+            // same as a SET_IDLE request, but in milliseconds. zero disables the idle report.
+            Generic_HID_Interface.State.IdleCount = (uint16_t)report->propertyValue;
+            Generic_HID_Interface.State.IdleMSRemaining = (uint16_t)report->propertyValue;
+            break;
+
+        case SPID_LIGHTS_FRAME_RATE:
+            Lights_SetFrameRate((uint16_t)report->propertyValue);
+            break;
+
+        case SPID_CONFIG_BANK:
+            // switches profiles without a usb reconnect, the adc keeps running.
+            // ConfigStore_Task applies the bank once a pending store is written.
+            ConfigStore_SelectBank(&CONFIGURATION, (uint8_t)report->propertyValue);
+            break;
+
+        case SPID_CONFIG_TRANSACTION:
+            if (report->propertyValue == CONFIG_TRANSACTION_BEGIN) {
+                ConfigStore_BeginTransaction();
+            }
+            else if (report->propertyValue == CONFIG_TRANSACTION_COMMIT) {
+                ApplyConfigurationChanges(ConfigStore_CommitTransaction());
+            }
+            else {
+                ConfigStore_AbortTransaction();
+            }
+            break;
+
+        case SPID_SCAN_ALL_SENSORS:
+            Pad_SetScanAllSensors(report->propertyValue != 0);
+            break;
         }
     }
 }
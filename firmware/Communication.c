@@ -1,28 +1,218 @@
 #include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+#include <avr/io.h>
+#include <util/atomic.h>
 
 #include "Config/DancePadConfig.h"
 #include "Communication.h"
+#include "Descriptors.h"
 #include "Pad.h"
 #include "Lights.h"
+#include "Timer.h"
+#include "Memory.h"
 
 const char boardType[] = BOARD_TYPE;
 
-void Communication_WriteInputHIDReport(InputHIDReport* report) {
-    // first, update pad state
-    Pad_UpdateState();
+// input reports are prebuilt whenever the pad state changes. the back buffer gets filled
+// and then swapped with the front buffer, which is what the host is handed on every poll.
+typedef struct {
+    uint8_t id;
+    uint8_t size;
+    uint32_t scanTime;
+    union {
+        InputHIDReport standard;
+        CompactInputHIDReport compact;
+        ExtremesInputHIDReport extremes;
+        AxesInputHIDReport axes;
+    };
+} PreparedInputReport;
 
-    // write buttons to the report
-    for (int i = 0; i < BUTTON_COUNT; i++) {
-        // trol https://stackoverflow.com/a/47990
-        report->buttons[i / 8] ^= (-PAD_STATE.buttonsPressed[i] ^ report->buttons[i / 8]) & (1UL << i % 8);
+static PreparedInputReport inputReports[2];
+static PreparedInputReport* frontInputReport = &inputReports[0];
+// starts as Configuration.inputReportMode, see SetupConfiguration
+static uint8_t inputReportMode = INPUT_REPORT_MODE_STANDARD;
+
+// when inputReportThreshold is non-zero reports are only sent when they change. sensor values
+// are only reported again once they move more than the threshold away from the last reported value.
+static uint16_t inputReportThreshold = 0;
+static uint16_t reportedSensorValues[SENSOR_COUNT];
+static bool inputReportPending = true;
+
+static uint8_t inputReportSequence = 0;
+
+// highest and lowest conversions since the last report was sent, for the extremes report
+static uint16_t sensorPeaks[SENSOR_COUNT];
+static uint16_t sensorTroughs[SENSOR_COUNT];
+static bool sensorExtremesReset = true;
+
+static void Communication_WriteButtons(uint8_t* buttons) {
+    memset(buttons, 0, CEILING(BUTTON_COUNT, 8));
+    for (uint8_t i = 0; i < BUTTON_COUNT; i++) {
+        if (PAD_STATE.buttonsPressed[i]) {
+            buttons[i / 8] |= 1 << (i % 8);
+        }
+    }
+}
+
+// packs the values of the wired sensors and returns the mask of the sensors included
+static uint16_t Communication_PackSensorValues(uint8_t* packed, const uint16_t* values) {
+    uint16_t mask = 0;
+    uint8_t bit = 0;
+
+    memset(packed, 0, COMPACT_SENSOR_VALUES_SIZE);
+
+    for (uint8_t i = 0; i < SENSOR_COUNT; i++) {
+        if (!ADC_IsSensorWired(i)) {
+            continue;
+        }
+
+        // values start at multiples of 10 bits, so a value never spans more than two bytes
+        uint16_t value = values[i] << (bit % 8);
+        packed[bit / 8] |= value & 0xFF;
+        packed[bit / 8 + 1] |= value >> 8;
+
+        mask |= 1 << i;
+        bit += COMPACT_SENSOR_BITS;
+    }
+
+    return mask;
+}
+
+static void Communication_WriteAxes(AxesInputHIDReport* report, const uint16_t* values) {
+    uint8_t axis = 0;
+
+    for (uint8_t i = 0; i < SENSOR_COUNT && axis < WIRED_SENSOR_COUNT; i++) {
+        if (ADC_IsSensorWired(i)) {
+            report->axes[axis++] = values[i];
+        }
     }
-   
-    // write sensor values to the report
-    for (int i = 0; i < SENSOR_COUNT; i++) {
-        report->sensorValues[i] = PAD_STATE.sensorValues[i];
+
+    while (axis < WIRED_SENSOR_COUNT) {
+        report->axes[axis++] = 0;
     }
 }
 
+static void Communication_UpdateSensorExtremes(void) {
+    for (uint8_t i = 0; i < SENSOR_COUNT; i++) {
+        if (sensorExtremesReset || PAD_STATE.sensorMaximums[i] > sensorPeaks[i]) {
+            sensorPeaks[i] = PAD_STATE.sensorMaximums[i];
+        }
+
+        if (sensorExtremesReset || PAD_STATE.sensorMinimums[i] < sensorTroughs[i]) {
+            sensorTroughs[i] = PAD_STATE.sensorMinimums[i];
+        }
+    }
+
+    sensorExtremesReset = false;
+}
+
+void Communication_SetInputReportMode(uint8_t mode) {
+    if (mode > INPUT_REPORT_MODE_AXES) {
+        return;
+    }
+
+    inputReportMode = mode;
+    Debug_Trace(TRACE_INPUT_REPORT_MODE, mode, 0);
+    Communication_UpdateInputHIDReport();
+}
+
+void Communication_SetInputReportThreshold(uint16_t threshold) {
+    inputReportThreshold = threshold;
+    Communication_UpdateInputHIDReport();
+}
+
+static void Communication_UpdateReportedSensorValues(void) {
+    for (uint8_t i = 0; i < SENSOR_COUNT; i++) {
+        uint16_t value = PAD_STATE.sensorValues[i];
+        uint16_t delta = value > reportedSensorValues[i] ? value - reportedSensorValues[i] : reportedSensorValues[i] - value;
+
+        if (delta > inputReportThreshold || inputReportThreshold == 0) {
+            reportedSensorValues[i] = value;
+        }
+    }
+}
+
+void Communication_UpdateInputHIDReport(void) {
+    PreparedInputReport* report = frontInputReport == &inputReports[0] ? &inputReports[1] : &inputReports[0];
+
+    Communication_UpdateReportedSensorValues();
+    Communication_UpdateSensorExtremes();
+    report->scanTime = PAD_STATE.scanTime;
+
+    if (inputReportMode == INPUT_REPORT_MODE_EXTREMES) {
+        report->id = EXTREMES_INPUT_REPORT_ID;
+        report->size = sizeof (ExtremesInputHIDReport);
+        Communication_WriteButtons(report->extremes.buttons);
+        report->extremes.sensorMask = Communication_PackSensorValues(report->extremes.sensorValues, reportedSensorValues);
+        Communication_PackSensorValues(report->extremes.sensorPeaks, sensorPeaks);
+        Communication_PackSensorValues(report->extremes.sensorTroughs, sensorTroughs);
+    } else if (inputReportMode == INPUT_REPORT_MODE_AXES) {
+        report->id = AXES_INPUT_REPORT_ID;
+        report->size = sizeof (AxesInputHIDReport);
+        Communication_WriteButtons(report->axes.buttons);
+        Communication_WriteAxes(&report->axes, reportedSensorValues);
+    } else if (inputReportMode == INPUT_REPORT_MODE_COMPACT) {
+        report->id = COMPACT_INPUT_REPORT_ID;
+        report->size = sizeof (CompactInputHIDReport);
+        Communication_WriteButtons(report->compact.buttons);
+        report->compact.sensorMask = Communication_PackSensorValues(report->compact.sensorValues, reportedSensorValues);
+    } else {
+        report->id = INPUT_REPORT_ID;
+        report->size = sizeof (InputHIDReport);
+        Communication_WriteButtons(report->standard.buttons);
+        memcpy(report->standard.sensorValues, reportedSensorValues, sizeof (report->standard.sensorValues));
+    }
+
+    // the trailer is only filled in when the report is sent, so leave it out of the comparison.
+    // peaks and troughs change with every bit of noise, they are only sent along with other changes.
+    uint8_t compareSize = report->size - sizeof (InputReportTrailer);
+    if (report->id == EXTREMES_INPUT_REPORT_ID) {
+        compareSize = offsetof(ExtremesInputHIDReport, sensorPeaks);
+    }
+    if (report->id != frontInputReport->id || memcmp(&report->standard, &frontInputReport->standard, compareSize) != 0) {
+        inputReportPending = true;
+    }
+
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        frontInputReport = report;
+    }
+}
+
+bool Communication_WriteInputHIDReport(uint8_t* reportId, void* report, uint16_t* reportSize, bool idlePeriodElapsed) {
+    // nothing changed since the last report was sent - leave the report size at zero so nothing goes out.
+    // pending debug records only set a flag in the trailer. traces are always built in and nobody may read
+    // them, so they must not keep reports going out.
+    if (inputReportThreshold != 0 && !inputReportPending && !idlePeriodElapsed) {
+        return false;
+    }
+
+    inputReportPending = false;
+    sensorExtremesReset = true;
+
+    *reportId = frontInputReport->id;
+    *reportSize = frontInputReport->size;
+    memcpy(report, &frontInputReport->standard, frontInputReport->size);
+
+    // the trailer is the last member of every input report
+    InputReportTrailer* trailer = (InputReportTrailer*)((uint8_t*)report + frontInputReport->size - sizeof (InputReportTrailer));
+    uint32_t sampleAge = Timer_Micros() - frontInputReport->scanTime;
+    trailer->sequence = inputReportSequence++;
+    trailer->sampleAge = sampleAge > 0xFFFF ? 0xFFFF : sampleAge;
+    trailer->flags = 0;
+
+    if (Pad_ButtonEventsPending())
+        trailer->flags |= INPUT_FLAG_BUTTON_EVENTS_PENDING;
+
+    if (ConfigStore_StorePending())
+        trailer->flags |= INPUT_FLAG_SAVE_PENDING;
+
+    if (Debug_Available() > 0)
+        trailer->flags |= INPUT_FLAG_DEBUG_PENDING;
+
+    return true;
+}
+
 void Communication_WriteIdentificationReport(IdentificationFeatureReport* ReportData) {
     ReportData->firmwareVersionMajor = FIRMWARE_VERSION_MAJOR;
     ReportData->firmwareVersionMinor = FIRMWARE_VERSION_MINOR;
@@ -44,6 +234,8 @@ void Communication_WriteIdentificationV2Report(IdentificationV2FeatureReport* Re
 		ReportData->features |= FEATURE_DEBUG;
 	#endif
 	
+	ReportData->features |= FEATURE_DEBUG_RECORDS;
+	
 	#if defined(FEATURE_DIGIPOT_ENABLED)
 		ReportData->features |= FEATURE_DIGIPOT;
 	#endif
@@ -51,4 +243,78 @@ void Communication_WriteIdentificationV2Report(IdentificationV2FeatureReport* Re
 	#if defined(FEATURE_LIGHTS_ENABLED)
 		ReportData->features |= FEATURE_LIGHTS;
 	#endif
-}
\ No newline at end of file
+	
+	#if defined(FEATURE_LED_FRAMES_ENABLED)
+		ReportData->features |= FEATURE_LED_FRAMES;
+	#endif
+	
+	ReportData->features |= FEATURE_COMPACT_INPUT_REPORT;
+	ReportData->features |= FEATURE_INPUT_REPORT_ON_CHANGE;
+	ReportData->features |= FEATURE_BUTTON_EVENTS;
+	ReportData->features |= FEATURE_SENSOR_EXTREMES;
+	ReportData->features |= FEATURE_CONFIG_BANKS;
+	ReportData->features |= FEATURE_MEMORY_USAGE;
+	ReportData->features |= FEATURE_CONFIG_DUMP;
+	ReportData->features |= FEATURE_CONFIG_WRITE;
+	ReportData->features |= FEATURE_AXES_INPUT_REPORT;
+	ReportData->features |= FEATURE_DEBUG_PENDING_FLAG;
+	ReportData->features |= FEATURE_SENSOR_SAMPLING;
+}
+
+void Communication_WriteConfigBanksReport(ConfigBanksHIDReport* report) {
+    report->bankCount = ConfigStore_BankCount();
+    report->activeBank = ConfigStore_ActiveBank();
+}
+
+void Communication_WriteMemoryUsageReport(MemoryUsageHIDReport* report) {
+    report->ramSize = RAMEND + 1 - RAMSTART;
+    report->staticSize = Memory_StaticSize();
+    report->free = Memory_Free();
+    report->stackHighWater = Memory_StackHighWater();
+}
+
+// offset of the next config dump page, always a multiple of CONFIG_DUMP_PAGE_SIZE
+static uint16_t configDumpOffset = 0;
+
+void Communication_WriteConfigDumpReport(ConfigDumpHIDReport* report) {
+    uint16_t length = sizeof (Configuration) - configDumpOffset;
+    if (length > CONFIG_DUMP_PAGE_SIZE) {
+        length = CONFIG_DUMP_PAGE_SIZE;
+    }
+
+    memset(report, 0, sizeof (ConfigDumpHIDReport));
+    report->layoutVersion = CONFIG_LAYOUT_VERSION;
+    report->offset = configDumpOffset;
+    report->size = sizeof (Configuration);
+    memcpy(report->data, (const uint8_t*) &CONFIGURATION + configDumpOffset, length);
+
+    configDumpOffset += CONFIG_DUMP_PAGE_SIZE;
+    if (configDumpOffset >= sizeof (Configuration)) {
+        configDumpOffset = 0;
+    }
+}
+
+uint8_t Communication_ReadConfigWriteReport(const ConfigWriteHIDReport* report) {
+    uint8_t size = report->size < CONFIG_WRITE_RECORDS_SIZE ? report->size : CONFIG_WRITE_RECORDS_SIZE;
+    uint8_t position = 0;
+    uint8_t changes = 0;
+
+    while (position + sizeof (ConfigWriteRecord) <= size) {
+        const ConfigWriteRecord* record = (const ConfigWriteRecord*) &report->records[position];
+        position += sizeof (ConfigWriteRecord);
+
+        if (record->length > size - position) {
+            break;
+        }
+
+        changes |= ConfigStore_Write(record->offset, &report->records[position], record->length);
+        position += record->length;
+    }
+
+    return changes;
+}
+
+void Communication_WriteButtonEventsReport(ButtonEventsHIDReport* report) {
+    memset(report, 0, sizeof (ButtonEventsHIDReport));
+    report->count = Pad_ReadButtonEvents(report->events, BUTTON_EVENTS_PER_REPORT, &report->dropped);
+}
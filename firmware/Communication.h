@@ -17,11 +17,64 @@
     // ie. from microcontroller to computer
     //
 
+    // appended to every input report. sequence is incremented for every report sent, so the host
+    // can count lost reports. sampleAge is the time in microseconds from the end of the scan the
+    // values come from until the report was handed to the usb controller, saturating at 0xFFFF.
+    typedef struct {
+        uint8_t sequence;
+        uint16_t sampleAge;
+        uint8_t flags;
+    } __attribute__((packed)) InputReportTrailer;
+
+    // values for InputReportTrailer.flags
+    #define INPUT_FLAG_BUTTON_EVENTS_PENDING 0x1
+    #define INPUT_FLAG_SAVE_PENDING 0x2
+    #define INPUT_FLAG_DEBUG_PENDING 0x4
+
     typedef struct {
         uint8_t buttons[CEILING(BUTTON_COUNT, 8)];
         uint16_t sensorValues[SENSOR_COUNT];
+        InputReportTrailer trailer;
     } __attribute__((packed)) InputHIDReport;
 
+    // bits per sensor value in the compact input report. adc values are 10 bit.
+    #define COMPACT_SENSOR_BITS 10
+
+    #define COMPACT_SENSOR_VALUES_SIZE CEILING(WIRED_SENSOR_COUNT * COMPACT_SENSOR_BITS, 8)
+
+    // only wired sensors are included, in sensor order. bit n of sensorMask is set when
+    // sensor n is included. values are packed little endian, COMPACT_SENSOR_BITS each.
+    typedef struct {
+        uint8_t buttons[CEILING(BUTTON_COUNT, 8)];
+        uint16_t sensorMask;
+        uint8_t sensorValues[COMPACT_SENSOR_VALUES_SIZE];
+        InputReportTrailer trailer;
+    } __attribute__((packed)) CompactInputHIDReport;
+
+    // compact report which also has the highest and lowest conversion of each sensor
+    // since the previous report was sent. all three are packed like the compact report.
+    typedef struct {
+        uint8_t buttons[CEILING(BUTTON_COUNT, 8)];
+        uint16_t sensorMask;
+        uint8_t sensorValues[COMPACT_SENSOR_VALUES_SIZE];
+        uint8_t sensorPeaks[COMPACT_SENSOR_VALUES_SIZE];
+        uint8_t sensorTroughs[COMPACT_SENSOR_VALUES_SIZE];
+        InputReportTrailer trailer;
+    } __attribute__((packed)) ExtremesInputHIDReport;
+
+    // wired sensors as standard joystick axes, in sensor order, so games can read them directly
+    typedef struct {
+        uint8_t buttons[CEILING(BUTTON_COUNT, 8)];
+        uint16_t axes[WIRED_SENSOR_COUNT];
+        InputReportTrailer trailer;
+    } __attribute__((packed)) AxesInputHIDReport;
+
+    // values for SPID_INPUT_REPORT_MODE
+    #define INPUT_REPORT_MODE_STANDARD 0
+    #define INPUT_REPORT_MODE_COMPACT  1
+    #define INPUT_REPORT_MODE_EXTREMES 2
+    #define INPUT_REPORT_MODE_AXES     3
+
     //
     // FEATURE REPORTS
     // ie. can be requested by computer and written by computer
@@ -50,10 +103,84 @@
         SensorConfig sensor;
     } __attribute__((packed)) SensorHIDReport;
 
+    //
+    // OUTPUT REPORTS
+    // ie. written by computer without a reply
+    //
+
+    #define LED_FRAME_REPORT_LEDS 20
+
+    // a run of streamed led colors, see Lights_WriteFrame
+    typedef struct {
+        uint8_t flags;
+        uint8_t ledIndex;
+        uint8_t ledCount;
+        rgb_color colors[LED_FRAME_REPORT_LEDS];
+    } __attribute__((packed)) LedFrameHIDReport;
+
+    typedef struct {
+        uint8_t bankCount;
+        uint8_t activeBank;
+    } __attribute__((packed)) ConfigBanksHIDReport;
+
+    // ram usage in bytes, see Memory.h
+    typedef struct {
+        uint16_t ramSize;
+        uint16_t staticSize;
+        uint16_t free;
+        uint16_t stackHighWater;
+    } __attribute__((packed)) MemoryUsageHIDReport;
+
+    #define CONFIG_DUMP_PAGE_SIZE 56
+
+    // a page of the whole configuration, laid out like Configuration. every read returns the next page
+    // and wraps around after the last one, so reading as many pages as there are returns all of them.
+    typedef struct {
+        uint8_t layoutVersion; // CONFIG_LAYOUT_VERSION
+        uint16_t offset; // of data within Configuration
+        uint16_t size; // of Configuration
+        uint8_t data[CONFIG_DUMP_PAGE_SIZE];
+    } __attribute__((packed)) ConfigDumpHIDReport;
+
+    #define CONFIG_WRITE_RECORDS_SIZE 60
+
+    // followed by length bytes, which are written to offset within Configuration
+    typedef struct {
+        uint16_t offset;
+        uint8_t length;
+    } __attribute__((packed)) ConfigWriteRecord;
+
+    // records back to back, size is the number of bytes of records used. applied right away, or on commit
+    // when a transaction is open, see SPID_CONFIG_TRANSACTION.
+    typedef struct {
+        uint8_t size;
+        uint8_t records[CONFIG_WRITE_RECORDS_SIZE];
+    } __attribute__((packed)) ConfigWriteHIDReport;
+
+    #define BUTTON_EVENTS_PER_REPORT 8
+
+    typedef struct {
+        uint8_t count;
+        uint8_t dropped;
+        ButtonEvent events[BUTTON_EVENTS_PER_REPORT];
+    } __attribute__((packed)) ButtonEventsHIDReport;
+
     // IDS used by SetPropertyHIDReport.
     #define SPID_SELECTED_LIGHT_RULE_INDEX  0
     #define SPID_SELECTED_LED_MAPPING_INDEX 1
     #define SPID_SELECTED_SENSOR_INDEX 2
+    #define SPID_INPUT_REPORT_MODE 3
+    #define SPID_INPUT_REPORT_THRESHOLD 4
+    #define SPID_INPUT_REPORT_IDLE 5
+    #define SPID_LIGHTS_FRAME_RATE 6
+    #define SPID_CONFIG_BANK 7
+    #define SPID_CONFIG_TRANSACTION 8
+    #define SPID_SCAN_ALL_SENSORS 9 // non-zero to scan sensors that are not used, see Pad_SetScanAllSensors
+
+    // values for SPID_CONFIG_TRANSACTION
+    #define CONFIG_TRANSACTION_ABORT  0
+    #define CONFIG_TRANSACTION_BEGIN  1
+    #define CONFIG_TRANSACTION_COMMIT 2
 
     typedef struct {
         uint32_t propertyId;
@@ -76,14 +203,23 @@
     } __attribute__((packed)) IdentificationV2FeatureReport;
 	
 	
-	#if defined(FEATURE_DEBUG_ENABLED)
-		typedef struct {
-			uint16_t messageSize;
-			char messagePacket[32];
-		} DebugHIDReport;
-	#endif
+	// the next messageSize bytes of debug records, see Debug.h
+	typedef struct {
+		uint16_t messageSize;
+		char messagePacket[32];
+	} DebugHIDReport;
 	
-    void Communication_WriteInputHIDReport(InputHIDReport* report);
+    void Communication_SetInputReportMode(uint8_t mode);
+    void Communication_SetInputReportThreshold(uint16_t threshold);
+    void Communication_UpdateInputHIDReport(void);
+    bool Communication_WriteInputHIDReport(uint8_t* reportId, void* report, uint16_t* reportSize, bool idlePeriodElapsed);
     void Communication_WriteIdentificationReport(IdentificationFeatureReport* report);
     void Communication_WriteIdentificationV2Report(IdentificationV2FeatureReport* report);
+    void Communication_WriteButtonEventsReport(ButtonEventsHIDReport* report);
+    void Communication_WriteConfigBanksReport(ConfigBanksHIDReport* report);
+    void Communication_WriteMemoryUsageReport(MemoryUsageHIDReport* report);
+    void Communication_WriteConfigDumpReport(ConfigDumpHIDReport* report);
+
+    // Writes the records of the report to the configuration, and returns the parts that changed.
+    uint8_t Communication_ReadConfigWriteReport(const ConfigWriteHIDReport* report);
 #endif
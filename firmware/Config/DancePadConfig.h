@@ -2,16 +2,38 @@
 #define _DANCE_PAD_CONFIG_H_
     //Version 2 since Kauhsa's initial version will be considered version 0
     #define FIRMWARE_VERSION_MAJOR 1
-    #define FIRMWARE_VERSION_MINOR 3
+    #define FIRMWARE_VERSION_MINOR 4
 
 	#define FEATURE_DEBUG 1 << 0
 	#define FEATURE_DIGIPOT 1 << 1
 	#define FEATURE_LIGHTS 1 << 2
+	#define FEATURE_COMPACT_INPUT_REPORT 1 << 3
+	#define FEATURE_INPUT_REPORT_ON_CHANGE 1 << 4
+	#define FEATURE_BUTTON_EVENTS 1 << 5
+	#define FEATURE_SENSOR_EXTREMES 1 << 6
+	#define FEATURE_LED_FRAMES 1 << 7
+	#define FEATURE_CONFIG_BANKS 1 << 8
+	#define FEATURE_MEMORY_USAGE 1 << 9
+	#define FEATURE_CONFIG_DUMP 1 << 10
+	#define FEATURE_CONFIG_WRITE 1 << 11
+	#define FEATURE_AXES_INPUT_REPORT 1 << 12
+	#define FEATURE_DEBUG_PENDING_FLAG 1 << 13
+	#define FEATURE_DEBUG_RECORDS 1 << 14
+	#define FEATURE_SENSOR_SAMPLING 1 << 15
 	
 	//#define FEATURE_DEBUG_ENABLED
 	//#define FEATURE_DIGIPOT_ENABLED
 	//#define FEATURE_LIGHTS_ENABLED
 	
+	// Drive the led strip with USART1 in SPI master mode instead of bit banging, which keeps
+	// interrupts enabled while the strip is written. Needs the strip data line on TXD1 (PD3).
+	// Building with "make LED_STRIP=USART" sets it as well.
+	//#define LED_STRIP_USART
+	
+	// Let the host stream led frames through LED_FRAME_REPORT_ID. The frame buffer takes
+	// LED_COUNT * 3 bytes of ram, so boards with long strips leave it off.
+	//#define FEATURE_LED_FRAMES_ENABLED
+
 	// Set the board type if not provided to the make command
     // #define BOARD_TYPE_
 
@@ -35,10 +57,13 @@
 		
 		#define FEATURE_LIGHTS_ENABLED
 		#define FEATURE_DIGIPOT_ENABLED
+		#define FEATURE_LED_FRAMES_ENABLED
 		
 		#define LED_PANELS 4
 		#define PANEL_LEDS 8
 		
+		#define WIRED_SENSOR_COUNT 4
+		
 		// Trigger existing exceptions
 		#define BOARD_TYPE_FSRMINIPAD
 	
@@ -47,10 +72,13 @@
         #define BOOTLOADER_ADDRESS "0x7000"
 		
 		#define FEATURE_LIGHTS_ENABLED
+		#define FEATURE_LED_FRAMES_ENABLED
 		
 		#define LED_PANELS 4
 		#define PANEL_LEDS 8
 		
+		#define WIRED_SENSOR_COUNT 4
+		
 	#elif defined(BOARD_TYPE_FSRIO_1)
         #define BOARD_TYPE "fsrio1";
         #define BOOTLOADER_ADDRESS "0x7000"
@@ -60,6 +88,8 @@
 		
 		#define LED_PANELS 8
 		#define PANEL_LEDS 8
+		
+		#define WIRED_SENSOR_COUNT 8
 
     #elif defined(BOARD_TYPE_TEENSY2)
     	#define BOARD_TYPE "teensy2";
@@ -75,9 +105,25 @@
 
     #endif
 	
+	// number of sensors that have an analog pin assigned in ADC.c
+	#if !defined(WIRED_SENSOR_COUNT)
+		#define WIRED_SENSOR_COUNT SENSOR_COUNT
+	#endif
+	
+	// minimum time between switching the muxer or digipot and starting a conversion on it
+	#if defined(FEATURE_DIGIPOT_ENABLED) && !defined(DIGIPOT_SETTLE_TIME_US)
+		#define DIGIPOT_SETTLE_TIME_US 10
+	#endif
+	
 	#if defined(FEATURE_LIGHTS_ENABLED)
 		#define LED_COUNT (LED_PANELS * PANEL_LEDS)
 	#else
 		#define LED_COUNT 0
+		#undef FEATURE_LED_FRAMES_ENABLED
+	#endif
+	
+	// lights frames per second until changed with SPID_LIGHTS_FRAME_RATE
+	#if !defined(LIGHTS_FRAME_RATE)
+		#define LIGHTS_FRAME_RATE 100
 	#endif
 #endif
@@ -1,21 +1,57 @@
 #include <string.h>
+#include <stddef.h>
 #include <stdint.h>
-#include <util/atomic.h>
 #include <avr/eeprom.h>
+#include <avr/pgmspace.h>
 
 #include "Config/DancePadConfig.h"
 #include "Pad.h"
 #include "ConfigStore.h"
+#include "Communication.h"
+#include "Debug.h"
+
+Configuration CONFIGURATION;
+
+// every bank starts with a header, which indicates that a pad configuration is, in fact, stored
+// and which layout it has. the configuration follows it.
+typedef struct {
+    uint8_t magic[3];
+    uint8_t layoutVersion;
+} __attribute__((packed)) BankHeader;
+
+// a change to Configuration that did not increment CONFIG_LAYOUT_VERSION would load old banks wrongly
+_Static_assert(sizeof (Configuration) == CONFIG_LAYOUT_SIZE(CONFIG_LAYOUT_VERSION), "Configuration changed, increment CONFIG_LAYOUT_VERSION");
+_Static_assert(offsetof(Configuration, inputReportMode) == CONFIG_LAYOUT_1_SIZE, "the 1.3 configuration is no longer a prefix of Configuration");
 
 // just some random bytes to figure out what we have in eeprom
-// change these to reset configuration!
-static const uint8_t magicBytes[5] = {9, 74, 9, FIRMWARE_VERSION_MAJOR, FIRMWARE_VERSION_MINOR};
+static const BankHeader bankHeader = { .magic = {9, 74, 9}, .layoutVersion = CONFIG_LAYOUT_VERSION };
+
+// firmware up to 1.3 stored a single configuration right after these magic bytes at address 0.
+// its layout is the current one without inputReportMode at the end.
+static const uint8_t legacyMagicBytes[5] = {9, 74, 9, 1, 3};
+#define LEGACY_CONFIGURATION_ADDRESS ((uint8_t *) sizeof (legacyMagicBytes))
+
+// where the index of the bank that is loaded at startup is stored
+#define ACTIVE_BANK_ADDRESS ((uint8_t *) 0x00)
+
+// as many banks as fit in eeprom follow the active bank index.
+#define BANK_SIZE (sizeof (BankHeader) + sizeof (Configuration))
+#define BANK_COUNT ((E2END + 1 - 1) / BANK_SIZE)
+#define BANK_HEADER_ADDRESS(bank) ((uint8_t *) 0x01 + (bank) * BANK_SIZE)
+#define CONFIGURATION_ADDRESS(bank) (BANK_HEADER_ADDRESS(bank) + sizeof (BankHeader))
 
-// where magic bytes (which indicate that a pad configuration is, in fact, stored) exist
-#define MAGIC_BYTES_ADDRESS ((void *) 0x00)
+// a store writes the configuration first, then the bank header and the active bank index
+#define STORE_SIZE (sizeof (Configuration) + sizeof (BankHeader) + 1)
 
-// where actual configration is stored
-#define CONFIGURATION_ADDRESS ((void *) (MAGIC_BYTES_ADDRESS + sizeof (magicBytes)))
+// unchanged bytes compared per ConfigStore_Task call, reading eeprom only takes a few cycles
+#define STORE_COMPARES_PER_TASK 32
+
+// configuration of the pending store, NULL when there is none
+static const Configuration* storeSource = NULL;
+// bank the pending store writes to
+static uint8_t storeBank;
+// next byte of the pending store to compare with eeprom
+static uint16_t storeOffset;
 
 #if defined(BOARD_TYPE_FSRMINIPAD)
 	#define DEFAULT_NAME "FSR Mini pad"
@@ -56,10 +92,12 @@ static const uint8_t magicBytes[5] = {9, 74, 9, FIRMWARE_VERSION_MAJOR, FIRMWARE
 	.releaseThreshold = 400 * 0.95,		\
 	.buttonMapping = button,			\
 	.resistorValue = 150,				\
-	.flags = 0							\
+	.flags = 0,							\
+	.sampling = 0						\
 	}
 
-static const Configuration DEFAULT_CONFIGURATION = {
+// kept in flash, it is only read on a factory reset or when eeprom holds no configuration
+static const Configuration DEFAULT_CONFIGURATION PROGMEM = {
     .padConfiguration = {
 		.sensors = {	
 		
@@ -123,34 +161,246 @@ static const Configuration DEFAULT_CONFIGURATION = {
 			DEFAULT_LED_MAPPING(0, 7, 7, 8)
 		}
 #endif
-	}
+	},
+    .inputReportMode = INPUT_REPORT_MODE_STANDARD
 };
 
+static uint8_t activeBank = 0;
+
+// bank requested by ConfigStore_SelectBank and the configuration it is loaded into, NULL when there is none
+static Configuration* selectTarget = NULL;
+static uint8_t selectBank;
+
+// Loads the configuration stored in the bank. A bank that was never stored, or that was stored with
+// another layout, is not loaded.
+static bool ConfigStore_LoadBank(Configuration* conf, uint8_t bank) {
+    BankHeader header;
+    eeprom_read_block(&header, BANK_HEADER_ADDRESS(bank), sizeof (BankHeader));
+
+    if (memcmp(&header, &bankHeader, sizeof (BankHeader)) != 0) {
+        return false;
+    }
+
+    // we had magic bytes, let's load the configuration!
+    eeprom_read_block(conf, CONFIGURATION_ADDRESS(bank), sizeof (Configuration));
+    return true;
+}
+
+// Loads the configuration stored by firmware 1.3 and stores it as bank 0.
+static bool ConfigStore_MigrateLegacy(Configuration* conf) {
+    uint8_t magicByteBuffer[sizeof (legacyMagicBytes)];
+    eeprom_read_block(magicByteBuffer, (const void *) 0x00, sizeof (legacyMagicBytes));
+
+    if (memcmp(magicByteBuffer, legacyMagicBytes, sizeof (legacyMagicBytes)) != 0) {
+        return false;
+    }
+
+    eeprom_read_block(conf, LEGACY_CONFIGURATION_ADDRESS, CONFIG_LAYOUT_1_SIZE);
+    conf->inputReportMode = INPUT_REPORT_MODE_STANDARD;
+
+    // the configuration is at the same address in bank 0, so only the header, inputReportMode and the
+    // active bank index are written. the active bank index replaces the first legacy magic byte last.
+    activeBank = 0;
+    ConfigStore_StoreConfiguration(conf);
+    ConfigStore_Flush();
+    return true;
+}
+
 void ConfigStore_LoadConfiguration(Configuration* conf) {
-    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
-        // see if we have magic bytes stored
-        uint8_t magicByteBuffer[sizeof (magicBytes)];
-        eeprom_read_block(magicByteBuffer, MAGIC_BYTES_ADDRESS, sizeof (magicBytes));
-
-        if (memcmp(magicByteBuffer, magicBytes, sizeof (magicBytes)) == 0) {
-            // we had magic bytes, let's load the configuration!
-            eeprom_read_block(conf, CONFIGURATION_ADDRESS, sizeof (Configuration));
+    // a migration only writes a few bytes, so it is stored right away
+    if (ConfigStore_MigrateLegacy(conf)) {
+        return;
+    }
+
+    activeBank = eeprom_read_byte(ACTIVE_BANK_ADDRESS);
+
+    if (activeBank >= BANK_COUNT) {
+        activeBank = 0;
+    }
+
+    if (!ConfigStore_LoadBank(conf, activeBank)) {
+        // we had some garbage on magic byte address, let's just use the default configuration
+        ConfigStore_FactoryDefaults(conf);
+    }
+}
+
+uint8_t ConfigStore_BankCount(void) {
+    return BANK_COUNT;
+}
+
+uint8_t ConfigStore_ActiveBank(void) {
+    return activeBank;
+}
+
+bool ConfigStore_SelectBank(Configuration* conf, uint8_t bank) {
+    if (bank >= BANK_COUNT || bank == activeBank) {
+        // also drops a switch to another bank that did not happen yet
+        selectTarget = NULL;
+        return false;
+    }
+
+    // this runs in the usb callback, where waiting for a pending store could take more than a second
+    selectTarget = conf;
+    selectBank = bank;
+    return true;
+}
+
+// Switches to the bank requested by ConfigStore_SelectBank, once no store reads from the configuration.
+static uint8_t ConfigStore_SwitchBank(void) {
+    if (selectTarget == NULL) {
+        return 0;
+    }
+
+    Configuration* conf = selectTarget;
+    selectTarget = NULL;
+
+    // a bank that was never stored starts as a copy of the current configuration
+    ConfigStore_LoadBank(conf, selectBank);
+    activeBank = selectBank;
+    Debug_Trace(TRACE_CONFIG_BANK_SELECTED, selectBank, 0);
+
+    // makes the bank the one loaded at startup, and stores it if it was empty
+    ConfigStore_StoreConfiguration(conf);
+    return CONFIG_CHANGED_PAD | CONFIG_CHANGED_LIGHTS;
+}
+
+void ConfigStore_StoreConfiguration(const Configuration* conf) {
+    // starting over also covers bytes changed behind the current offset
+    storeSource = conf;
+    storeBank = activeBank;
+    storeOffset = 0;
+}
+
+uint8_t ConfigStore_Task(void) {
+    if (storeSource == NULL) {
+        return ConfigStore_SwitchBank();
+    }
+
+    // a byte write takes about 3.4ms, which the eeprom does on its own with interrupts enabled
+    if (!eeprom_is_ready()) {
+        return 0;
+    }
+
+    for (uint8_t compares = 0; compares < STORE_COMPARES_PER_TASK; ++compares) {
+        if (storeOffset == STORE_SIZE) {
+            storeSource = NULL;
+            Debug_Trace(TRACE_CONFIG_STORED, storeBank, 0);
+            return 0;
+        }
+
+        uint8_t* address;
+        uint8_t value;
+
+        if (storeOffset < sizeof (Configuration)) {
+            address = CONFIGURATION_ADDRESS(storeBank) + storeOffset;
+            value = ((const uint8_t*) storeSource)[storeOffset];
+        } else if (storeOffset < sizeof (Configuration) + sizeof (BankHeader)) {
+            address = BANK_HEADER_ADDRESS(storeBank) + (storeOffset - sizeof (Configuration));
+            value = ((const uint8_t*) &bankHeader)[storeOffset - sizeof (Configuration)];
         } else {
-            // we had some garbage on magic byte address, let's just use the default configuration
-            ConfigStore_FactoryDefaults(conf);
+            address = ACTIVE_BANK_ADDRESS;
+            value = storeBank;
+        }
+
+        storeOffset++;
+
+        if (eeprom_read_byte(address) != value) {
+            eeprom_write_byte(address, value);
+            return 0;
         }
     }
+
+    return 0;
 }
 
-void ConfigStore_StoreConfiguration(const Configuration* conf) {
-    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
-        eeprom_update_block(conf, CONFIGURATION_ADDRESS, sizeof (Configuration));
-        eeprom_update_block(magicBytes, MAGIC_BYTES_ADDRESS, sizeof (magicBytes));
+bool ConfigStore_StorePending(void) {
+    return storeSource != NULL;
+}
+
+void ConfigStore_Flush(void) {
+    while (ConfigStore_StorePending()) {
+        ConfigStore_Task();
     }
 }
 
-void ConfigStore_FactoryDefaults (Configuration* conf) {
-    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
-        memcpy(conf, &DEFAULT_CONFIGURATION, sizeof(Configuration));
+// writes of an open transaction are staged here as they arrive, laid out like the records of a
+// ConfigWriteHIDReport, and copied to CONFIGURATION on commit. a transaction that does not fit is dropped as a whole.
+static uint8_t transactionRecords[CONFIG_TRANSACTION_SIZE];
+static uint8_t transactionSize = 0;
+static bool transactionOpen = false;
+static bool transactionOverflow = false;
+
+static uint8_t ConfigStore_ChangedParts(uint16_t offset, uint8_t length) {
+    uint8_t changes = 0;
+
+    if (offset < offsetof(Configuration, padConfiguration) + sizeof (PadConfigurationV2)) {
+        changes |= CONFIG_CHANGED_PAD;
     }
+
+    if (offset + length > offsetof(Configuration, lightConfiguration)
+        && offset < offsetof(Configuration, lightConfiguration) + sizeof (LightConfiguration)) {
+        changes |= CONFIG_CHANGED_LIGHTS;
+    }
+
+    return changes;
+}
+
+static uint8_t ConfigStore_Apply(uint16_t offset, const uint8_t* data, uint8_t length) {
+    memcpy((uint8_t*) &CONFIGURATION + offset, data, length);
+    return ConfigStore_ChangedParts(offset, length);
+}
+
+uint8_t ConfigStore_Write(uint16_t offset, const uint8_t* data, uint8_t length) {
+    if (length == 0 || offset >= sizeof (Configuration) || length > sizeof (Configuration) - offset) {
+        return 0;
+    }
+
+    if (!transactionOpen) {
+        return ConfigStore_Apply(offset, data, length);
+    }
+
+    uint16_t recordSize = sizeof (ConfigWriteRecord) + length;
+    if (transactionOverflow || recordSize > CONFIG_TRANSACTION_SIZE - transactionSize) {
+        transactionOverflow = true;
+        return 0;
+    }
+
+    ConfigWriteRecord* record = (ConfigWriteRecord*) &transactionRecords[transactionSize];
+    record->offset = offset;
+    record->length = length;
+    memcpy(record + 1, data, length);
+    transactionSize += recordSize;
+    return 0;
+}
+
+void ConfigStore_BeginTransaction(void) {
+    transactionOpen = true;
+    transactionOverflow = false;
+    transactionSize = 0;
+}
+
+uint8_t ConfigStore_CommitTransaction(void) {
+    uint8_t changes = 0;
+
+    if (!transactionOpen || transactionOverflow) {
+        transactionOpen = false;
+        return 0;
+    }
+
+    for (uint8_t position = 0; position < transactionSize; ) {
+        const ConfigWriteRecord* record = (const ConfigWriteRecord*) &transactionRecords[position];
+        changes |= ConfigStore_Apply(record->offset, (const uint8_t*) (record + 1), record->length);
+        position += sizeof (ConfigWriteRecord) + record->length;
+    }
+
+    transactionOpen = false;
+    return changes;
+}
+
+void ConfigStore_AbortTransaction(void) {
+    transactionOpen = false;
+}
+
+void ConfigStore_FactoryDefaults (Configuration* conf) {
+    memcpy_P(conf, &DEFAULT_CONFIGURATION, sizeof(Configuration));
 }
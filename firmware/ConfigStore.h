@@ -14,9 +14,73 @@
         PadConfigurationV2 padConfiguration;
         NameAndSize nameAndSize;
 		LightConfiguration lightConfiguration;
+        // INPUT_REPORT_MODE_*, the mode the pad starts in. SPID_INPUT_REPORT_MODE only changes it until a reset.
+        uint8_t inputReportMode;
     } __attribute__((packed)) Configuration;
+
+    // layout of Configuration as stored in eeprom and sent by the config dump report. whenever Configuration
+    // changes, increment it and add the size of the new layout below. banks stored with another layout are
+    // not loaded, the pad starts from the defaults instead.
+    #define CONFIG_LAYOUT_VERSION 2
+
+    // size of Configuration in each layout version
+    #define CONFIG_LAYOUT_1_SIZE 438 // firmware 1.3, without inputReportMode
+    #define CONFIG_LAYOUT_2_SIZE 439
+    #define CONFIG_LAYOUT_SIZE(version) CONFIG_LAYOUT_SIZE_(version)
+    #define CONFIG_LAYOUT_SIZE_(version) CONFIG_LAYOUT_ ## version ## _SIZE
+
+    // the configuration the pad runs with. modules read their part through PAD_CONF and LIGHT_CONF,
+    // after changing it call Pad_UpdateConfiguration or Lights_UpdateConfiguration.
+    extern Configuration CONFIGURATION;
+
+    #define PAD_CONF (CONFIGURATION.padConfiguration)
+    #define LIGHT_CONF (CONFIGURATION.lightConfiguration)
 	
+    // Loads the configuration of the bank that was active when the pad was last stored.
     void ConfigStore_LoadConfiguration(Configuration* conf);
-    void ConfigStore_StoreConfiguration(const Configuration* conf);
     void ConfigStore_FactoryDefaults(Configuration* conf);
+
+    // Number of configurations that fit in eeprom.
+    uint8_t ConfigStore_BankCount(void);
+    uint8_t ConfigStore_ActiveBank(void);
+
+    // Requests loading the configuration of another bank into conf and making it the active bank, which
+    // later stores write to. ConfigStore_Task switches once a pending store is written, since that store
+    // reads from conf. Returns false if the bank does not exist or is already active.
+    bool ConfigStore_SelectBank(Configuration* conf, uint8_t bank);
+
+    // Starts storing the configuration in the background. Bytes are written one at a time by
+    // ConfigStore_Task, so conf must stay valid. Later changes to it are picked up while storing.
+    void ConfigStore_StoreConfiguration(const Configuration* conf);
+
+    // Writes the next changed byte of a pending store once the eeprom is ready, or switches to a requested
+    // bank. Call it from the main loop. Returns the parts of the configuration that changed, like ConfigStore_Write.
+    uint8_t ConfigStore_Task(void);
+
+    // True until a pending store is completely written.
+    bool ConfigStore_StorePending(void);
+
+    // Blocks until a pending store is completely written.
+    void ConfigStore_Flush(void);
+
+    // parts of CONFIGURATION changed by writes or a bank switch, which need Pad_UpdateConfiguration or Lights_UpdateConfiguration
+    #define CONFIG_CHANGED_PAD    0x1
+    #define CONFIG_CHANGED_LIGHTS 0x2
+
+    // bytes a transaction can stage, each write takes its length plus a ConfigWriteRecord
+    #define CONFIG_TRANSACTION_SIZE 160
+
+    // Copies length bytes to offset within CONFIGURATION, or stages them while a transaction is open.
+    // Returns the parts of CONFIGURATION that changed, zero when the write was staged or out of range.
+    uint8_t ConfigStore_Write(uint16_t offset, const uint8_t* data, uint8_t length);
+
+    // Stages the following writes until the transaction is committed. Once more than
+    // CONFIG_TRANSACTION_SIZE bytes are staged, the whole transaction is dropped.
+    void ConfigStore_BeginTransaction(void);
+
+    // Applies all staged writes at once and returns the parts of CONFIGURATION they changed.
+    uint8_t ConfigStore_CommitTransaction(void);
+
+    // Drops the staged writes.
+    void ConfigStore_AbortTransaction(void);
 #endif
@@ -1,47 +1,125 @@
+#include <stdbool.h>
+#include <string.h>
+
 #include "Debug.h"
+#include "Timer.h"
 #include "Config/DancePadConfig.h"
 
-#if defined(FEATURE_DEBUG_ENABLED)
-
+// must be a power of two, no larger than 256
 #define DEBUG_BUFFER_SIZE 128
 
-char debugBuffer [DEBUG_BUFFER_SIZE];
-volatile uint16_t debugBufferAvailable = 0;
+// longer messages are cut off, so a message always fits in an empty buffer
+#define DEBUG_MAX_TEXT_LENGTH 64
+
+// keeps the compiler from moving buffer accesses past the index update that hands them over
+#define DEBUG_BARRIER() __asm__ __volatile__ ("" ::: "memory")
+
+// lock-free ring buffer with a single writer in the main loop and a single reader. the indices run
+// freely and wrap at 256, so head - tail is the number of bytes stored. the writer fills the bytes
+// of a whole record before it moves the head, the reader copies bytes out before it moves the tail.
+// both indices are single bytes, so they are read and written atomically without disabling interrupts.
+static uint8_t debugBuffer[DEBUG_BUFFER_SIZE];
+static volatile uint8_t debugHead = 0;
+static volatile uint8_t debugTail = 0;
+static uint8_t debugDropped = 0;
 
-void Debug_MoveBuffer(uint16_t position) {
-	debugBufferAvailable -= position;
-	memcpy(debugBuffer, debugBuffer + position, debugBufferAvailable);
+static uint8_t Debug_Free(void) {
+	return DEBUG_BUFFER_SIZE - (uint8_t)(debugHead - debugTail);
 }
 
-void Debug_Message(const char* message) {
-	uint16_t freeBufferSpace = DEBUG_BUFFER_SIZE - debugBufferAvailable;
-	uint16_t readLength = strlen(message);
-	if(readLength > freeBufferSpace) {
-		readLength = freeBufferSpace;
+// copies bytes behind head, and returns the head after them. nothing is visible to the reader yet.
+static uint8_t Debug_Write(uint8_t head, const void* data, uint8_t length) {
+	const uint8_t* bytes = data;
+
+	for (uint8_t i = 0; i < length; i++) {
+		debugBuffer[(uint8_t)(head + i) % DEBUG_BUFFER_SIZE] = bytes[i];
 	}
-	
-	memcpy(debugBuffer + debugBufferAvailable, message, readLength);
-	debugBufferAvailable += readLength;
+
+	return head + length;
 }
 
-void Debug_ReadBuffer(char* target, uint16_t length) {
-	if(length > debugBufferAvailable) {
-		length = debugBufferAvailable;
+static uint8_t Debug_WriteTrace(uint8_t head, uint8_t event, uint16_t arg0, uint16_t arg1) {
+	DebugTraceRecord record = {
+		.type = DEBUG_RECORD_TRACE,
+		.event = event,
+		.args = { arg0, arg1 },
+		.time = Timer_Micros()
+	};
+
+	return Debug_Write(head, &record, sizeof (record));
+}
+
+// hands the records written up to head over to the reader
+static void Debug_Publish(uint8_t head) {
+	DEBUG_BARRIER();
+	debugHead = head;
+}
+
+// makes room for a record of length bytes, first writing a trace of earlier drops if there are any.
+// returns false if the record does not fit, otherwise where to write it.
+static bool Debug_Reserve(uint8_t length, uint8_t* head) {
+	uint8_t needed = debugDropped > 0 ? length + sizeof (DebugTraceRecord) : length;
+
+	if (Debug_Free() < needed) {
+		if (debugDropped < UINT8_MAX) {
+			debugDropped++;
+		}
+		return false;
+	}
+
+	*head = debugHead;
+
+	if (debugDropped > 0) {
+		*head = Debug_WriteTrace(*head, TRACE_DROPPED, debugDropped, 0);
+		debugDropped = 0;
+	}
+
+	return true;
+}
+
+#if defined(FEATURE_DEBUG_ENABLED)
+void Debug_Message(const char* message) {
+	size_t length = strlen(message);
+	DebugTextRecord record = {
+		.type = DEBUG_RECORD_TEXT,
+		.length = length > DEBUG_MAX_TEXT_LENGTH ? DEBUG_MAX_TEXT_LENGTH : length
+	};
+	uint8_t head;
+
+	if (Debug_Reserve(sizeof (record) + record.length, &head)) {
+		head = Debug_Write(head, &record, sizeof (record));
+		Debug_Publish(Debug_Write(head, message, record.length));
 	}
-	
-	memcpy(target, debugBuffer, length);
-	Debug_MoveBuffer(length);
 }
+#endif
+
+void Debug_Trace(uint8_t event, uint16_t arg0, uint16_t arg1) {
+	uint8_t head;
 
-uint16_t Debug_Available() {
-	return debugBufferAvailable;
+	if (Debug_Reserve(sizeof (DebugTraceRecord), &head)) {
+		Debug_Publish(Debug_WriteTrace(head, event, arg0, arg1));
+	}
 }
 
-#else
+uint8_t Debug_ReadBuffer(uint8_t* target, uint8_t length) {
+	uint8_t tail = debugTail;
+	uint8_t available = debugHead - tail;
+
+	if (length > available) {
+		length = available;
+	}
+
+	DEBUG_BARRIER();
 
-void Debug_Init() {;}
-void Debug_Message(const char* message) {;}
-void Debug_ReadBuffer(char* target, uint16_t length) {;}
-uint16_t Debug_Available() { return 0; }
+	for (uint8_t i = 0; i < length; i++) {
+		target[i] = debugBuffer[(uint8_t)(tail + i) % DEBUG_BUFFER_SIZE];
+	}
+
+	DEBUG_BARRIER();
+	debugTail = tail + length;
+	return length;
+}
 
-#endif
\ No newline at end of file
+uint16_t Debug_Available(void) {
+	return (uint8_t)(debugHead - debugTail);
+}
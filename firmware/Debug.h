@@ -2,9 +2,50 @@
 #define _DEBUG_H_
 
 #include <stdint.h>
+#include "Config/DancePadConfig.h"
 
-void Debug_Message(const char* message);
-void Debug_ReadBuffer(char* target, uint16_t length);
-uint16_t Debug_Available();
+// the debug buffer holds records back to back, each starting with one of these types
+enum DebugRecordTypes
+{
+	DEBUG_RECORD_TEXT  = 0x1, // DebugTextRecord followed by length characters
+	DEBUG_RECORD_TRACE = 0x2, // DebugTraceRecord
+};
 
-#endif
\ No newline at end of file
+typedef struct {
+	uint8_t type;
+	uint8_t length;
+} __attribute__((packed)) DebugTextRecord;
+
+typedef struct {
+	uint8_t type;
+	uint8_t event;
+	uint16_t args[2];
+	uint32_t time; // Timer_Micros when the record was written
+} __attribute__((packed)) DebugTraceRecord;
+
+// events of trace records, and what their args are
+enum DebugTraceEvents
+{
+	TRACE_DROPPED              = 0, // records lost to a full buffer since the previous one
+	TRACE_CONFIG_STORED        = 1, // bank the configuration was stored to
+	TRACE_CONFIG_BANK_SELECTED = 2, // bank
+	TRACE_INPUT_REPORT_MODE    = 3, // mode
+	TRACE_LIGHTS_FRAME_SKIPPED = 4, // the previous frame was still being sent
+};
+
+// Records are written whole or dropped. The buffer has a single producer, so only write records from
+// the main loop, never from interrupts. Trace records are cheap enough to stay in every build, text
+// messages take flash for their strings and are only kept with FEATURE_DEBUG_ENABLED.
+void Debug_Trace(uint8_t event, uint16_t arg0, uint16_t arg1);
+#if defined(FEATURE_DEBUG_ENABLED)
+	void Debug_Message(const char* message);
+#else
+	static inline void Debug_Message(const char* message) { ; }
+#endif
+
+// Copies up to length bytes of records to target, and returns how many were copied.
+// Records may be split over several reads. There is a single reader, which may run in an interrupt.
+uint8_t Debug_ReadBuffer(uint8_t* target, uint8_t length);
+uint16_t Debug_Available(void);
+
+#endif
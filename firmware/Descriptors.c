@@ -27,6 +27,58 @@
 #include "Descriptors.h"
 #include "Communication.h"
 
+// the items below are shared by the input report variants, each expands to a list of items without
+// a trailing comma. the padding of the packed sensor values cannot be conditional inside a macro,
+// so it is chosen here.
+
+// BUTTON_COUNT buttons, one bit each. TODO: padding here if BUTTON_COUNT not divisible by 8
+#define INPUT_REPORT_BUTTONS \
+    HID_RI_USAGE_PAGE(8, 0x09), \
+    HID_RI_USAGE_MINIMUM(8, 0x01), \
+    HID_RI_USAGE_MAXIMUM(8, BUTTON_COUNT), \
+    HID_RI_LOGICAL_MINIMUM(8, 0x00), \
+    HID_RI_LOGICAL_MAXIMUM(8, 0x01), \
+    HID_RI_REPORT_SIZE(8, 0x01), \
+    HID_RI_REPORT_COUNT(8, BUTTON_COUNT), \
+    HID_RI_INPUT(8, HID_IOF_DATA | HID_IOF_VARIABLE | HID_IOF_ABSOLUTE)
+
+// mask of the sensors whose values follow
+#define INPUT_REPORT_SENSOR_HEADER \
+    HID_RI_USAGE(8, 0x03), \
+    HID_RI_LOGICAL_MINIMUM(8, 0x00), \
+    HID_RI_LOGICAL_MAXIMUM(8, 0xFF), \
+    HID_RI_REPORT_SIZE(8, 0x08), \
+    HID_RI_REPORT_COUNT(8, sizeof (uint16_t)), \
+    HID_RI_INPUT(8, HID_IOF_DATA | HID_IOF_VARIABLE | HID_IOF_ABSOLUTE)
+
+#if (WIRED_SENSOR_COUNT * COMPACT_SENSOR_BITS) % 8
+    #define INPUT_REPORT_COMPACT_PADDING , \
+        HID_RI_REPORT_SIZE(8, 8 - (WIRED_SENSOR_COUNT * COMPACT_SENSOR_BITS) % 8), \
+        HID_RI_REPORT_COUNT(8, 1), \
+        HID_RI_INPUT(8, HID_IOF_CONSTANT)
+#else
+    #define INPUT_REPORT_COMPACT_PADDING
+#endif
+
+// WIRED_SENSOR_COUNT values packed into COMPACT_SENSOR_BITS each, padded to whole bytes
+#define INPUT_REPORT_COMPACT_SENSORS(usage) \
+    HID_RI_USAGE(8, usage), \
+    HID_RI_LOGICAL_MINIMUM(8, 0x00), \
+    HID_RI_LOGICAL_MAXIMUM(16, (1 << COMPACT_SENSOR_BITS) - 1), \
+    HID_RI_REPORT_SIZE(8, COMPACT_SENSOR_BITS), \
+    HID_RI_REPORT_COUNT(8, WIRED_SENSOR_COUNT), \
+    HID_RI_INPUT(8, HID_IOF_DATA | HID_IOF_VARIABLE | HID_IOF_ABSOLUTE) \
+    INPUT_REPORT_COMPACT_PADDING
+
+// sequence and sample age, see InputReportTrailer
+#define INPUT_REPORT_TRAILER \
+    HID_RI_USAGE(8, 0x04), \
+    HID_RI_LOGICAL_MINIMUM(8, 0x00), \
+    HID_RI_LOGICAL_MAXIMUM(8, 0xFF), \
+    HID_RI_REPORT_SIZE(8, 0x08), \
+    HID_RI_REPORT_COUNT(8, sizeof (InputReportTrailer)), \
+    HID_RI_INPUT(8, HID_IOF_DATA | HID_IOF_VARIABLE | HID_IOF_ABSOLUTE)
+
 /** HID class report descriptor. This is a special descriptor constructed with values from the
  *  USBIF HID class specification to describe the reports and capabilities of the HID device. This
  *  descriptor is parsed by the host and its contents used to determine what data (and in what encoding)
@@ -40,15 +92,7 @@ const USB_Descriptor_HIDReport_Datatype_t PROGMEM GenericReport[] =
     HID_RI_USAGE(8, 0x04),
     HID_RI_COLLECTION(8, 0x01),
         HID_RI_REPORT_ID(8, INPUT_REPORT_ID),
-        HID_RI_USAGE_PAGE(8, 0x09),
-        HID_RI_USAGE_MINIMUM(8, 0x01),
-        HID_RI_USAGE_MAXIMUM(8, BUTTON_COUNT),
-        HID_RI_LOGICAL_MINIMUM(8, 0x00),
-        HID_RI_LOGICAL_MAXIMUM(8, 0x01),
-        HID_RI_REPORT_SIZE(8, 0x01),
-        HID_RI_REPORT_COUNT(8, BUTTON_COUNT),
-        HID_RI_INPUT(8, HID_IOF_DATA | HID_IOF_VARIABLE | HID_IOF_ABSOLUTE),
-        // TODO: padding here if BUTTON_COUNT not divisible by 8
+        INPUT_REPORT_BUTTONS,
         HID_RI_USAGE_PAGE(16, 0xFF00), // vendor usage page
         HID_RI_USAGE(8, 0x01),
         HID_RI_COLLECTION(8, 0x00),
@@ -58,6 +102,67 @@ const USB_Descriptor_HIDReport_Datatype_t PROGMEM GenericReport[] =
             HID_RI_REPORT_SIZE(8, 0x08),
             HID_RI_REPORT_COUNT(8, SENSOR_COUNT * 2),
             HID_RI_INPUT(8, HID_IOF_DATA | HID_IOF_VARIABLE | HID_IOF_ABSOLUTE),
+            INPUT_REPORT_TRAILER,
+        HID_RI_END_COLLECTION(0),
+
+        // compact variant of the input report, see CompactInputHIDReport
+        HID_RI_REPORT_ID(8, COMPACT_INPUT_REPORT_ID),
+        INPUT_REPORT_BUTTONS,
+        HID_RI_USAGE_PAGE(16, 0xFF00), // vendor usage page
+        HID_RI_USAGE(8, 0x01),
+        HID_RI_COLLECTION(8, 0x00),
+            INPUT_REPORT_SENSOR_HEADER,
+            INPUT_REPORT_COMPACT_SENSORS(0x01),
+            INPUT_REPORT_TRAILER,
+        HID_RI_END_COLLECTION(0),
+
+        // compact input report with sensor peaks and troughs, see ExtremesInputHIDReport
+        HID_RI_REPORT_ID(8, EXTREMES_INPUT_REPORT_ID),
+        INPUT_REPORT_BUTTONS,
+        HID_RI_USAGE_PAGE(16, 0xFF00), // vendor usage page
+        HID_RI_USAGE(8, 0x01),
+        HID_RI_COLLECTION(8, 0x00),
+            INPUT_REPORT_SENSOR_HEADER,
+            INPUT_REPORT_COMPACT_SENSORS(0x01),
+            INPUT_REPORT_COMPACT_SENSORS(0x05), // peaks
+            INPUT_REPORT_COMPACT_SENSORS(0x06), // troughs
+            INPUT_REPORT_TRAILER,
+        HID_RI_END_COLLECTION(0),
+
+        // input report with the wired sensors as joystick axes, see AxesInputHIDReport.
+        // the first six are X, Y, Z, Rx, Ry and Rz, the remaining ones are sliders.
+        HID_RI_REPORT_ID(8, AXES_INPUT_REPORT_ID),
+        INPUT_REPORT_BUTTONS,
+        HID_RI_USAGE_PAGE(8, 0x01),
+        HID_RI_USAGE(8, 0x30),
+        #if WIRED_SENSOR_COUNT > 1
+            HID_RI_USAGE(8, 0x31),
+        #endif
+        #if WIRED_SENSOR_COUNT > 2
+            HID_RI_USAGE(8, 0x32),
+        #endif
+        #if WIRED_SENSOR_COUNT > 3
+            HID_RI_USAGE(8, 0x33),
+        #endif
+        #if WIRED_SENSOR_COUNT > 4
+            HID_RI_USAGE(8, 0x34),
+        #endif
+        #if WIRED_SENSOR_COUNT > 5
+            HID_RI_USAGE(8, 0x35),
+        #endif
+        #if WIRED_SENSOR_COUNT > 6
+            // the last usage repeats for the rest of the report count
+            HID_RI_USAGE(8, 0x36),
+        #endif
+        HID_RI_LOGICAL_MINIMUM(8, 0x00),
+        HID_RI_LOGICAL_MAXIMUM(16, MAX_SENSOR_VALUE - 1),
+        HID_RI_REPORT_SIZE(8, 16),
+        HID_RI_REPORT_COUNT(8, WIRED_SENSOR_COUNT),
+        HID_RI_INPUT(8, HID_IOF_DATA | HID_IOF_VARIABLE | HID_IOF_ABSOLUTE),
+        HID_RI_USAGE_PAGE(16, 0xFF00), // vendor usage page
+        HID_RI_USAGE(8, 0x01),
+        HID_RI_COLLECTION(8, 0x00),
+            INPUT_REPORT_TRAILER,
         HID_RI_END_COLLECTION(0),
 
         HID_RI_REPORT_ID(8, PAD_CONFIGURATION_REPORT_ID),
@@ -178,19 +283,17 @@ const USB_Descriptor_HIDReport_Datatype_t PROGMEM GenericReport[] =
             HID_RI_FEATURE(8, HID_IOF_DATA | HID_IOF_VARIABLE | HID_IOF_ABSOLUTE | HID_IOF_NON_VOLATILE),
         HID_RI_END_COLLECTION(0),
 		
-		#if defined(FEATURE_DEBUG_ENABLED)
-			HID_RI_REPORT_ID(8, DEBUG_REPORT_ID),
-			HID_RI_USAGE_PAGE(16, 0xFF00), // vendor usage page
+		HID_RI_REPORT_ID(8, DEBUG_REPORT_ID),
+		HID_RI_USAGE_PAGE(16, 0xFF00), // vendor usage page
+		HID_RI_USAGE(8, 0x02),
+		HID_RI_COLLECTION(8, 0x00),
 			HID_RI_USAGE(8, 0x02),
-			HID_RI_COLLECTION(8, 0x00),
-				HID_RI_USAGE(8, 0x02),
-				HID_RI_LOGICAL_MINIMUM(8, 0x00),
-				HID_RI_LOGICAL_MAXIMUM(8, 0xFF),
-				HID_RI_REPORT_SIZE(8, 0x08),
-				HID_RI_REPORT_COUNT(8, sizeof(DebugHIDReport)),
-				HID_RI_FEATURE(8, HID_IOF_DATA | HID_IOF_VARIABLE | HID_IOF_ABSOLUTE | HID_IOF_NON_VOLATILE),
-			HID_RI_END_COLLECTION(0),
-		#endif
+			HID_RI_LOGICAL_MINIMUM(8, 0x00),
+			HID_RI_LOGICAL_MAXIMUM(8, 0xFF),
+			HID_RI_REPORT_SIZE(8, 0x08),
+			HID_RI_REPORT_COUNT(8, sizeof(DebugHIDReport)),
+			HID_RI_FEATURE(8, HID_IOF_DATA | HID_IOF_VARIABLE | HID_IOF_ABSOLUTE | HID_IOF_NON_VOLATILE),
+		HID_RI_END_COLLECTION(0),
 		
 		HID_RI_REPORT_ID(8, IDENTIFICATION_V2_REPORT_ID),
 		HID_RI_USAGE_PAGE(16, 0xFF00), // vendor usage page
@@ -204,6 +307,78 @@ const USB_Descriptor_HIDReport_Datatype_t PROGMEM GenericReport[] =
 			HID_RI_FEATURE(8, HID_IOF_DATA | HID_IOF_VARIABLE | HID_IOF_ABSOLUTE | HID_IOF_NON_VOLATILE),
 		HID_RI_END_COLLECTION(0),
 
+		HID_RI_REPORT_ID(8, BUTTON_EVENTS_REPORT_ID),
+		HID_RI_USAGE_PAGE(16, 0xFF00), // vendor usage page
+		HID_RI_USAGE(8, 0x02),
+		HID_RI_COLLECTION(8, 0x00),
+			HID_RI_USAGE(8, 0x02),
+			HID_RI_LOGICAL_MINIMUM(8, 0x00),
+			HID_RI_LOGICAL_MAXIMUM(8, 0xFF),
+			HID_RI_REPORT_SIZE(8, 0x08),
+			HID_RI_REPORT_COUNT(8, sizeof(ButtonEventsHIDReport)),
+			HID_RI_FEATURE(8, HID_IOF_DATA | HID_IOF_VARIABLE | HID_IOF_ABSOLUTE | HID_IOF_NON_VOLATILE),
+		HID_RI_END_COLLECTION(0),
+
+		HID_RI_REPORT_ID(8, CONFIG_BANKS_REPORT_ID),
+		HID_RI_USAGE_PAGE(16, 0xFF00), // vendor usage page
+		HID_RI_USAGE(8, 0x02),
+		HID_RI_COLLECTION(8, 0x00),
+			HID_RI_USAGE(8, 0x02),
+			HID_RI_LOGICAL_MINIMUM(8, 0x00),
+			HID_RI_LOGICAL_MAXIMUM(8, 0xFF),
+			HID_RI_REPORT_SIZE(8, 0x08),
+			HID_RI_REPORT_COUNT(8, sizeof(ConfigBanksHIDReport)),
+			HID_RI_FEATURE(8, HID_IOF_DATA | HID_IOF_VARIABLE | HID_IOF_ABSOLUTE | HID_IOF_NON_VOLATILE),
+		HID_RI_END_COLLECTION(0),
+
+		HID_RI_REPORT_ID(8, LED_FRAME_REPORT_ID),
+		HID_RI_USAGE_PAGE(16, 0xFF00), // vendor usage page
+		HID_RI_USAGE(8, 0x02),
+		HID_RI_COLLECTION(8, 0x00),
+			HID_RI_USAGE(8, 0x02),
+			HID_RI_LOGICAL_MINIMUM(8, 0x00),
+			HID_RI_LOGICAL_MAXIMUM(8, 0xFF),
+			HID_RI_REPORT_SIZE(8, 0x08),
+			HID_RI_REPORT_COUNT(8, sizeof(LedFrameHIDReport)),
+			HID_RI_OUTPUT(8, HID_IOF_DATA | HID_IOF_VARIABLE | HID_IOF_ABSOLUTE | HID_IOF_NON_VOLATILE),
+		HID_RI_END_COLLECTION(0),
+
+		HID_RI_REPORT_ID(8, MEMORY_USAGE_REPORT_ID),
+		HID_RI_USAGE_PAGE(16, 0xFF00), // vendor usage page
+		HID_RI_USAGE(8, 0x02),
+		HID_RI_COLLECTION(8, 0x00),
+			HID_RI_USAGE(8, 0x02),
+			HID_RI_LOGICAL_MINIMUM(8, 0x00),
+			HID_RI_LOGICAL_MAXIMUM(8, 0xFF),
+			HID_RI_REPORT_SIZE(8, 0x08),
+			HID_RI_REPORT_COUNT(8, sizeof(MemoryUsageHIDReport)),
+			HID_RI_FEATURE(8, HID_IOF_DATA | HID_IOF_VARIABLE | HID_IOF_ABSOLUTE | HID_IOF_NON_VOLATILE),
+		HID_RI_END_COLLECTION(0),
+
+		HID_RI_REPORT_ID(8, CONFIG_DUMP_REPORT_ID),
+		HID_RI_USAGE_PAGE(16, 0xFF00), // vendor usage page
+		HID_RI_USAGE(8, 0x02),
+		HID_RI_COLLECTION(8, 0x00),
+			HID_RI_USAGE(8, 0x02),
+			HID_RI_LOGICAL_MINIMUM(8, 0x00),
+			HID_RI_LOGICAL_MAXIMUM(8, 0xFF),
+			HID_RI_REPORT_SIZE(8, 0x08),
+			HID_RI_REPORT_COUNT(8, sizeof(ConfigDumpHIDReport)),
+			HID_RI_FEATURE(8, HID_IOF_DATA | HID_IOF_VARIABLE | HID_IOF_ABSOLUTE | HID_IOF_NON_VOLATILE),
+		HID_RI_END_COLLECTION(0),
+
+		HID_RI_REPORT_ID(8, CONFIG_WRITE_REPORT_ID),
+		HID_RI_USAGE_PAGE(16, 0xFF00), // vendor usage page
+		HID_RI_USAGE(8, 0x02),
+		HID_RI_COLLECTION(8, 0x00),
+			HID_RI_USAGE(8, 0x02),
+			HID_RI_LOGICAL_MINIMUM(8, 0x00),
+			HID_RI_LOGICAL_MAXIMUM(8, 0xFF),
+			HID_RI_REPORT_SIZE(8, 0x08),
+			HID_RI_REPORT_COUNT(8, sizeof(ConfigWriteHIDReport)),
+			HID_RI_FEATURE(8, HID_IOF_DATA | HID_IOF_VARIABLE | HID_IOF_ABSOLUTE | HID_IOF_NON_VOLATILE),
+		HID_RI_END_COLLECTION(0),
+
     HID_RI_END_COLLECTION(0)
 };
 
@@ -82,11 +82,18 @@
         #define SET_PROPERTY_REPORT_ID           0xB
 		#define SENSOR_REPORT_ID      			 0xC
 		
-		#if defined(FEATURE_DEBUG_ENABLED)
-			#define DEBUG_REPORT_ID      	     0xD
-		#endif
+		#define DEBUG_REPORT_ID      	         0xD
 		
 		#define IDENTIFICATION_V2_REPORT_ID      0xE
+		#define COMPACT_INPUT_REPORT_ID          0xF
+		#define BUTTON_EVENTS_REPORT_ID          0x10
+		#define EXTREMES_INPUT_REPORT_ID         0x11
+		#define LED_FRAME_REPORT_ID              0x12
+		#define CONFIG_BANKS_REPORT_ID           0x13
+		#define MEMORY_USAGE_REPORT_ID           0x14
+		#define CONFIG_DUMP_REPORT_ID            0x15
+		#define CONFIG_WRITE_REPORT_ID           0x16
+		#define AXES_INPUT_REPORT_ID             0x17
 
     /* Macros: */
         /** Endpoint address of the Generic HID reporting IN endpoint. */
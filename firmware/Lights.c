@@ -1,17 +1,169 @@
 #include <avr/io.h>
 #include <avr/interrupt.h>
+#include <avr/pgmspace.h>
 #include <util/delay.h>
 #include <stdint.h>
-#include "Pad.h"
-#include "Lights.h"
-
-LightConfiguration LIGHT_CONF;
+#include <string.h>
+#include "ConfigStore.h"
+#include "Timer.h"
+#include "Debug.h"
 
 #if defined(FEATURE_LIGHTS_ENABLED)
 
 
-// Skip every x amount of light updates to improve polling rate
-#define UPDATE_WAIT_CYCLES 10
+// timer3 runs in CTC mode with prescaler 256 and sets lightsFrameDue at the frame rate
+#define FRAME_TIMER_HZ (F_CPU / 256)
+#define MAX_FRAME_RATE 1000
+
+static volatile bool lightsFrameDue = false;
+
+// A run of consecutive leds that show the same color, or consecutive colors if sequence is set.
+typedef struct
+{
+  const rgb_color* color;
+  uint16_t count;
+  bool sequence;
+} LedSegment;
+
+#if defined(LED_STRIP_USART)
+
+// USART1 in SPI master mode shifts out 3 bits for every bit of led data: 100 for a zero, 110 for a one.
+// at F_CPU / 6 = 2.67MHz that gives 375ns and 750ns high times in a 1.125us bit.
+// an empty transmitter keeps the line low, so a refill may be delayed by a few microseconds, but
+// no longer or the strip latches mid frame. the UDRE interrupt only copies an encoded byte to the
+// transmit buffer before anything else, so other interrupts have to stay that short as well.
+#define LED_STRIP_UBRR 2
+
+// 3 bits per data bit, 12 bits per nibble
+static const uint16_t PROGMEM ledStripNibbles[16] = {
+	0x924, 0x926, 0x934, 0x936, 0x9A4, 0x9A6, 0x9B4, 0x9B6,
+	0xD24, 0xD26, 0xD34, 0xD36, 0xDA4, 0xDA6, 0xDB4, 0xDB6
+};
+
+static const LedSegment* volatile ledStripSegment;
+static const rgb_color* volatile ledStripColor;
+static volatile uint8_t ledStripSegmentsLeft;
+static volatile uint16_t ledStripSegmentLeds;
+static volatile uint8_t ledStripComponent;
+
+// encoded bytes waiting to be sent, a color component takes 3. must be a power of two.
+// the indices run freely, head - tail is the number of bytes encoded ahead.
+#define LED_STRIP_ENCODED_SIZE 8
+static uint8_t ledStripEncoded[LED_STRIP_ENCODED_SIZE];
+static volatile uint8_t ledStripEncodedHead;
+static volatile uint8_t ledStripEncodedTail;
+
+static volatile bool ledStripWriting = false;
+static bool ledStripInitialized = false;
+
+static void led_strip_init(void)
+{
+  UBRR1 = 0;
+  DDRD |= (1 << DDD3) | (1 << DDD5); // TXD1 and XCK1 as outputs
+  PORTD &= ~(1 << DDD3);
+  UCSR1C = (1 << UMSEL11) | (1 << UMSEL10); // SPI master, msb first, mode 0
+  UCSR1B = (1 << TXEN1);
+  UBRR1 = LED_STRIP_UBRR;
+  ledStripInitialized = true;
+}
+
+// Returns true while a frame is being shifted out.
+static bool led_strip_busy(void)
+{
+  if (!ledStripWriting)
+    return false;
+
+  // done once the last byte left the shift register
+  if (!(UCSR1B & (1 << UDRIE1)) && (UCSR1A & (1 << TXC1)))
+    ledStripWriting = false;
+
+  return ledStripWriting;
+}
+
+// Encodes the next color component into ledStripEncoded, if there is room and a component left.
+static void led_strip_encode_next(void)
+{
+  uint8_t head = ledStripEncodedHead;
+
+  if (ledStripSegmentLeds == 0 || (uint8_t)(head - ledStripEncodedTail) > LED_STRIP_ENCODED_SIZE - 3)
+    return;
+
+  // the strip expects green, red, blue
+  const rgb_color* color = ledStripColor;
+  uint8_t value = ledStripComponent == 0 ? color->green : ledStripComponent == 1 ? color->red : color->blue;
+
+  if (++ledStripComponent == 3) {
+    ledStripComponent = 0;
+
+    const LedSegment* segment = ledStripSegment;
+
+    if (--ledStripSegmentLeds != 0) {
+      if (segment->sequence)
+        ledStripColor = color + 1;
+    }
+    else if (--ledStripSegmentsLeft != 0) {
+      ledStripSegment = ++segment;
+      ledStripSegmentLeds = segment->count;
+      ledStripColor = segment->color;
+    }
+  }
+
+  uint16_t high = pgm_read_word(&ledStripNibbles[value >> 4]);
+  uint16_t low = pgm_read_word(&ledStripNibbles[value & 0x0F]);
+  ledStripEncoded[head++ % LED_STRIP_ENCODED_SIZE] = high >> 4;
+  ledStripEncoded[head++ % LED_STRIP_ENCODED_SIZE] = (high << 4) | (low >> 8);
+  ledStripEncoded[head++ % LED_STRIP_ENCODED_SIZE] = low;
+  ledStripEncodedHead = head;
+}
+
+ISR(USART1_UDRE_vect)
+{
+  uint8_t tail = ledStripEncodedTail;
+
+  if (tail == ledStripEncodedHead) {
+    UCSR1B &= ~(1 << UDRIE1);
+    return;
+  }
+
+  UDR1 = ledStripEncoded[tail % LED_STRIP_ENCODED_SIZE];
+  ledStripEncodedTail = tail + 1;
+
+  // a refill that came late lets the transmitter run empty and sets TXC1 mid frame. clearing it once
+  // the final byte is queued makes led_strip_busy wait for that byte to leave the shift register.
+  if (ledStripEncodedTail == ledStripEncodedHead && ledStripSegmentLeds == 0)
+    UCSR1A = (1 << TXC1);
+
+  // the usart holds two bytes now, which leaves a few microseconds to encode ahead
+  led_strip_encode_next();
+}
+
+// Starts sending the segments to the strip in the background. The segments and the colors
+// they point to must not be changed until led_strip_busy returns false.
+static void led_strip_write(const LedSegment* segments, uint8_t segmentCount)
+{
+  if (!ledStripInitialized)
+    led_strip_init();
+
+  while (led_strip_busy()) ;
+
+  if (segmentCount == 0)
+    return;
+
+  ledStripSegment = segments;
+  ledStripColor = segments->color;
+  ledStripSegmentsLeft = segmentCount;
+  ledStripSegmentLeds = segments->count;
+  ledStripComponent = 0;
+  ledStripEncodedHead = ledStripEncodedTail = 0;
+  led_strip_encode_next();
+  led_strip_encode_next();
+
+  ledStripWriting = true;
+  UCSR1A = (1 << TXC1); // clear transmit complete
+  UCSR1B |= (1 << UDRIE1);
+}
+
+#else
 
 #if defined(BOARD_TYPE_FSRIO_1)
 	#define LED_STRIP_PORT PORTB
@@ -23,11 +175,10 @@ LightConfiguration LIGHT_CONF;
 	#define LED_STRIP_PIN  6
 #endif
 
-// led_strip_write sends a series of colors to the LED strip, updating the LEDs.
-// The colors parameter should point to an array of rgb_color structs that hold
-// the colors to send.
+// led_strip_write sends a series of segments to the LED strip, updating the LEDs.
+// Every segment sends its color, or its sequence of colors, to the given number of consecutive LEDs.
 
-void __attribute__((noinline)) led_strip_write(rgb_color * colors, uint16_t count)
+static void __attribute__((noinline)) led_strip_write(const LedSegment* segments, uint8_t segmentCount)
 {
   // Set the pin to be an output driving low.
   LED_STRIP_PORT &= ~(1<<LED_STRIP_PIN);
@@ -35,8 +186,22 @@ void __attribute__((noinline)) led_strip_write(rgb_color * colors, uint16_t coun
 
   cli();   // Disable interrupts temporarily because we don't want our pulse timing to be messed up.
   
-  while (count--)
+#if defined(BOARD_TYPE_FSRIO_1) && defined(FEATURE_DIGIPOT_ENABLED)
+  // SPI takes over the led pin while the adc interrupts load the digipot. A load takes a few microseconds,
+  // and no new one starts while interrupts are disabled.
+  while (SPCR & (1 << SPE)) {
+    sei(); asm volatile("nop\n"); cli();
+  }
+#endif
+  
+  for (const LedSegment* segment = segments; segment < segments + segmentCount; ++segment)
   {
+   const rgb_color* next = segment->color;
+
+   for (uint16_t count = segment->count; count > 0; --count)
+   {
+    const rgb_color* colors = next;
+
     // Send a color to the LED strip.
     // The assembly below also increments the 'colors' pointer,
     // it will be pointing to the next color at the end of this loop.
@@ -83,105 +248,382 @@ void __attribute__((noinline)) led_strip_write(rgb_color * colors, uint16_t coun
           "I" (LED_STRIP_PIN)     // %3 is the pin number (0-8)
     );
 
+    if (segment->sequence)
+      next = colors;
+
     // Uncomment the line below to temporarily enable interrupts between each color.
     //sei(); asm volatile("nop\n"); cli();
+   }
   }
   sei();          // Re-enable interrupts now that we are done.
 }
 
-static rgb_color LED_COLORS[LED_COUNT];
-
-long map(long x, long in_min, long in_max, long out_min, long out_max) {
-  return (x - in_min) * (out_max - out_min) / (in_max - in_min) + out_min;
+static bool led_strip_busy(void)
+{
+  return false;
 }
 
-void Lights_UpdateConfiguration(const LightConfiguration* lightConfiguration) {
-    memcpy(&LIGHT_CONF, lightConfiguration, sizeof (LightConfiguration));
-	Lights_Update(true);
-}
+#endif
 
-int updateWait = 0;
+// 2.2 gamma correction, applied to every color written to the strip
+static const uint8_t PROGMEM gammaTable[256] = {
+	  0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   1,
+	  1,   1,   1,   1,   1,   1,   1,   1,   1,   2,   2,   2,   2,   2,   2,   2,
+	  3,   3,   3,   3,   3,   4,   4,   4,   4,   5,   5,   5,   5,   6,   6,   6,
+	  6,   7,   7,   7,   8,   8,   8,   9,   9,   9,  10,  10,  11,  11,  11,  12,
+	 12,  13,  13,  13,  14,  14,  15,  15,  16,  16,  17,  17,  18,  18,  19,  19,
+	 20,  20,  21,  22,  22,  23,  23,  24,  25,  25,  26,  26,  27,  28,  28,  29,
+	 30,  30,  31,  32,  33,  33,  34,  35,  35,  36,  37,  38,  39,  39,  40,  41,
+	 42,  43,  43,  44,  45,  46,  47,  48,  49,  49,  50,  51,  52,  53,  54,  55,
+	 56,  57,  58,  59,  60,  61,  62,  63,  64,  65,  66,  67,  68,  69,  70,  71,
+	 73,  74,  75,  76,  77,  78,  79,  81,  82,  83,  84,  85,  87,  88,  89,  90,
+	 91,  93,  94,  95,  97,  98,  99, 100, 102, 103, 105, 106, 107, 109, 110, 111,
+	113, 114, 116, 117, 119, 120, 121, 123, 124, 126, 127, 129, 130, 132, 133, 135,
+	137, 138, 140, 141, 143, 145, 146, 148, 149, 151, 153, 154, 156, 158, 159, 161,
+	163, 165, 166, 168, 170, 172, 173, 175, 177, 179, 181, 182, 184, 186, 188, 190,
+	192, 194, 196, 197, 199, 201, 203, 205, 207, 209, 211, 213, 215, 217, 219, 221,
+	223, 225, 227, 229, 231, 234, 236, 238, 240, 242, 244, 246, 248, 251, 253, 255,
+};
 
-void Lights_Update(bool force)
+// color differences between the start and end of the fades of a rule,
+// scaled by an 8.8 fixed point fade fraction to get the color change
+typedef struct
 {
-	if(updateWait > 0 && !force) {
-		updateWait --;
-		return;
-	}
-	
-	for (uint8_t led = 0; led < LED_COUNT; ++led) {
-		LED_COLORS[led] = (rgb_color) {0, 0, 0};
-	}
+	int16_t on[3];
+	int16_t off[3];
+} LightRuleSlopes;
+
+static LightRuleSlopes ruleSlopes[MAX_LIGHT_RULES];
+
+// 0.16 fixed point reciprocals of the sensor thresholds, rounded up
+static uint16_t fadeReciprocals[SENSOR_COUNT];
+
+// the output color of every mapping in the frame last written to the strip
+static rgb_color mappingColors[MAX_LED_MAPPINGS];
+
+// color of leds that are not covered by an enabled mapping
+static const rgb_color unmappedColor = {0, 0, 0};
+
+// the strip split into runs that take their color from the same mapping, covering all LED_COUNT leds.
+// every mapping adds at most two boundaries, so the list size does not depend on the strip length.
+#define MAX_LED_SEGMENTS (MAX_LED_MAPPINGS * 2 + 1)
+static LedSegment ledSegments[MAX_LED_SEGMENTS];
+static uint8_t ledSegmentCount = 0;
+
+#if defined(FEATURE_LED_FRAMES_ENABLED)
+// frames streamed by the host. runs are gamma corrected into a single buffer, which the strip
+// is written from on the first lights frame after LFF_SHOW.
+#define STREAM_TIMEOUT_US 1000000UL
+
+static rgb_color streamColors[LED_COUNT];
+static const LedSegment streamSegment = { streamColors, LED_COUNT, true };
+static bool streaming = false;
+static bool streamShowPending = false;
+static uint32_t streamLastWrite;
+
+static rgb_color Lights_Gamma(rgb_color color);
+#endif
+
+const LightRule* Lights_MappingRule(const LedMapping* mapping) {
+	if (!(mapping->flags & LMF_ENABLED))
+		return NULL;
+
+	const LightRule* rule = &LIGHT_CONF.lightRules[mapping->lightRuleIndex];
+
+	if (!(rule->flags & LRF_ENABLED))
+		return NULL;
+
+	return rule;
+}
+
+// Splits the strip into segments by the mapping that owns each led.
+// Where mappings overlap, the one with the highest index wins.
+static void Lights_UpdateSegments(void) {
+	uint16_t bounds[MAX_LED_MAPPINGS * 2 + 2];
+	uint8_t boundCount = 0;
 	
-	updateWait = UPDATE_WAIT_CYCLES;
-	bool update = false;
+	bounds[boundCount++] = 0;
+	bounds[boundCount++] = LED_COUNT;
 	
 	for (uint8_t m = 0; m < MAX_LED_MAPPINGS; ++m)
 	{
         const LedMapping* mapping = &LIGHT_CONF.ledMappings[m];
 
-        if (!(mapping->flags & LMF_ENABLED))
-            continue;
-
-        const LightRule* rule = &LIGHT_CONF.lightRules[mapping->lightRuleIndex];
-
-        if (!(rule->flags & LRF_ENABLED))
+        if (Lights_MappingRule(mapping) == NULL)
             continue;
+		
+		bounds[boundCount++] = mapping->ledIndexBegin < LED_COUNT ? mapping->ledIndexBegin : LED_COUNT;
+		bounds[boundCount++] = mapping->ledIndexEnd < LED_COUNT ? mapping->ledIndexEnd : LED_COUNT;
+	}
+	
+	// insertion sort, there are only a few bounds
+	for (uint8_t i = 1; i < boundCount; ++i) {
+		uint16_t bound = bounds[i];
+		uint8_t j = i;
+		
+		for (; j > 0 && bounds[j - 1] > bound; --j) {
+			bounds[j] = bounds[j - 1];
+		}
+		
+		bounds[j] = bound;
+	}
+	
+	ledSegmentCount = 0;
+	
+	for (uint8_t i = 0; i + 1 < boundCount; ++i) {
+		uint16_t begin = bounds[i];
+		uint16_t end = bounds[i + 1];
+		
+		if (begin == end)
+			continue;
+		
+		const rgb_color* color = &unmappedColor;
+		
+		for (uint8_t m = 0; m < MAX_LED_MAPPINGS; ++m)
+		{
+			const LedMapping* mapping = &LIGHT_CONF.ledMappings[m];
 			
-		update = true;
+			if (Lights_MappingRule(mapping) != NULL && mapping->ledIndexBegin <= begin && begin < mapping->ledIndexEnd)
+				color = &mappingColors[m];
+		}
 		
-		SensorConfig s = PAD_CONF.sensors[mapping->sensorIndex];
-		uint16_t sensorValue = PAD_STATE.sensorValues[mapping->sensorIndex];
-		uint16_t sensorThreshold = s.threshold;
+		if (ledSegmentCount > 0 && ledSegments[ledSegmentCount - 1].color == color) {
+			ledSegments[ledSegmentCount - 1].count += end - begin;
+		}
+		else {
+			ledSegments[ledSegmentCount++] = (LedSegment) { color, end - begin, false };
+		}
+	}
+}
+
+static void Lights_UpdateSlopes(void) {
+	for (uint8_t r = 0; r < MAX_LIGHT_RULES; ++r)
+	{
+		const LightRule* rule = &LIGHT_CONF.lightRules[r];
+		LightRuleSlopes* slopes = &ruleSlopes[r];
 		
-		bool sensorState = sensorValue > sensorThreshold;
+		slopes->on[0] = rule->onFadeColor.red - rule->onColor.red;
+		slopes->on[1] = rule->onFadeColor.green - rule->onColor.green;
+		slopes->on[2] = rule->onFadeColor.blue - rule->onColor.blue;
+		slopes->off[0] = rule->offFadeColor.red - rule->offColor.red;
+		slopes->off[1] = rule->offFadeColor.green - rule->offColor.green;
+		slopes->off[2] = rule->offFadeColor.blue - rule->offColor.blue;
+	}
+}
+
+void Lights_UpdateThresholds(void) {
+	for (uint8_t sensor = 0; sensor < SENSOR_COUNT; ++sensor)
+	{
+		uint16_t threshold = PAD_CONF.sensors[sensor].threshold;
+		
+		// a zero threshold never fades, see Lights_FadeFraction
+		fadeReciprocals[sensor] = threshold > 0 ? (0x10000UL + threshold - 1) / threshold : 0;
+	}
+}
+
+ISR(TIMER3_COMPA_vect) {
+	lightsFrameDue = true;
+}
+
+void Lights_SetFrameRate(uint16_t framesPerSecond) {
+	TCCR3B = 0;
+	TIMSK3 &= ~(1 << OCIE3A);
+	lightsFrameDue = false;
+	
+	if (framesPerSecond == 0)
+		return;
+	
+	if (framesPerSecond > MAX_FRAME_RATE)
+		framesPerSecond = MAX_FRAME_RATE;
+	
+	TCCR3A = 0;
+	TCNT3 = 0;
+	OCR3A = FRAME_TIMER_HZ / framesPerSecond - 1;
+	TIMSK3 |= (1 << OCIE3A);
+	TCCR3B = (1 << WGM32) | (1 << CS32);
+}
+
+void Lights_Task(void) {
+	if (!lightsFrameDue)
+		return;
+	
+	lightsFrameDue = false;
+	
+#if defined(FEATURE_LED_FRAMES_ENABLED)
+	// the host stopped streaming without telling us
+	if (streaming && Timer_Micros() - streamLastWrite > STREAM_TIMEOUT_US) {
+		streaming = false;
+		Lights_Update(true);
+		return;
+	}
+#endif
+	
+	Lights_Update(false);
+}
+
+#if defined(FEATURE_LED_FRAMES_ENABLED)
+void Lights_WriteFrame(uint8_t flags, uint8_t ledIndex, uint8_t ledCount, const rgb_color* colors) {
+	// the strip may still be sent from the buffer
+	while (led_strip_busy()) ;
+	
+	if (flags & LFF_STOP) {
+		if (streaming) {
+			streaming = false;
+			Lights_Update(true);
+		}
 		
-		rgb_color color;
+		return;
+	}
+	
+	if (!streaming) {
+		memset(streamColors, 0, sizeof (streamColors));
+		streaming = true;
+	}
+	
+	if (ledIndex < LED_COUNT) {
+		if (ledCount > LED_COUNT - ledIndex)
+			ledCount = LED_COUNT - ledIndex;
 		
-		if(sensorState == true) {
-			if(rule->flags & LRF_FADE_ON) {
-				uint16_t sensorThreshold2 = sensorThreshold * 2;
-				
-				if(sensorValue <= sensorThreshold2) {				
-					color = (rgb_color) {	
-						map(sensorValue, sensorThreshold, sensorThreshold2, rule->onColor.red,   rule->onFadeColor.red),
-						map(sensorValue, sensorThreshold, sensorThreshold2, rule->onColor.green, rule->onFadeColor.green),
-						map(sensorValue, sensorThreshold, sensorThreshold2, rule->onColor.blue,  rule->onFadeColor.blue)
-					};
-				}
-				else {
-					color = rule->onFadeColor;
-				}
-			}
-			else {
-				color = rule->onColor;
-			}
+		for (uint8_t led = 0; led < ledCount; ++led) {
+			streamColors[ledIndex + led] = Lights_Gamma(colors[led]);
+		}
+	}
+	
+	if (flags & LFF_SHOW)
+		streamShowPending = true;
+	
+	streamLastWrite = Timer_Micros();
+}
+#else
+void Lights_WriteFrame(uint8_t flags, uint8_t ledIndex, uint8_t ledCount, const rgb_color* colors) { ; }
+#endif
+
+void Lights_UpdateConfiguration(void) {
+	// the segments are read while a frame is sent
+	while (led_strip_busy()) ;
+	
+	Lights_UpdateSlopes();
+	Lights_UpdateThresholds();
+	Lights_UpdateSegments();
+	Lights_Update(true);
+	
+	// sensors that only drive a light are scanned as well
+	Pad_UpdateScanList();
+}
+
+// Returns value / threshold of the sensor as an 8.8 fixed point fraction, clamped to 1.
+static uint16_t Lights_FadeFraction(uint8_t sensor, uint16_t value) {
+	uint16_t threshold = PAD_CONF.sensors[sensor].threshold;
+	
+	if (value >= threshold)
+		return 0x100;
+	
+	return ((uint32_t) value * fadeReciprocals[sensor]) >> 8;
+}
+
+static rgb_color Lights_Fade(rgb_color from, const int16_t* slope, uint16_t fraction) {
+	return (rgb_color) {
+		from.red   + (int16_t) (((int32_t) slope[0] * fraction) >> 8),
+		from.green + (int16_t) (((int32_t) slope[1] * fraction) >> 8),
+		from.blue  + (int16_t) (((int32_t) slope[2] * fraction) >> 8)
+	};
+}
+
+static rgb_color Lights_Gamma(rgb_color color) {
+	return (rgb_color) {
+		pgm_read_byte(&gammaTable[color.red]),
+		pgm_read_byte(&gammaTable[color.green]),
+		pgm_read_byte(&gammaTable[color.blue])
+	};
+}
+
+static rgb_color Lights_MappingColor(const LedMapping* mapping, const LightRule* rule) {
+	uint16_t sensorValue = PAD_STATE.sensorValues[mapping->sensorIndex];
+	uint16_t sensorThreshold = PAD_CONF.sensors[mapping->sensorIndex].threshold;
+	const LightRuleSlopes* slopes = &ruleSlopes[mapping->lightRuleIndex];
+	
+	bool sensorState = sensorValue > sensorThreshold;
+	
+	rgb_color color;
+	
+	if(sensorState == true) {
+		if(rule->flags & LRF_FADE_ON) {
+			// fades from threshold to twice the threshold
+			uint16_t fraction = Lights_FadeFraction(mapping->sensorIndex, sensorValue - sensorThreshold);
+			color = Lights_Fade(rule->onColor, slopes->on, fraction);
 		}
 		else {
-			if(rule->flags & LRF_FADE_OFF) {
-				color = (rgb_color) {	
-					map(sensorValue, 0, sensorThreshold, rule->offColor.red,   rule->offFadeColor.red),
-					map(sensorValue, 0, sensorThreshold, rule->offColor.green, rule->offFadeColor.green),
-					map(sensorValue, 0, sensorThreshold, rule->offColor.blue,  rule->offFadeColor.blue)
-				};
-			}
-			else {
-				color = rule->offColor;
-			}
+			color = rule->onColor;
 		}
+	}
+	else {
+		if(rule->flags & LRF_FADE_OFF) {
+			uint16_t fraction = Lights_FadeFraction(mapping->sensorIndex, sensorValue);
+			color = Lights_Fade(rule->offColor, slopes->off, fraction);
+		}
+		else {
+			color = rule->offColor;
+		}
+	}
+	
+	return Lights_Gamma(color);
+}
+
+void Lights_Update(bool force)
+{
+	// the previous frame is still being sent from mappingColors or streamColors, skip this one
+	while(led_strip_busy()) {
+		if(!force) {
+			Debug_Trace(TRACE_LIGHTS_FRAME_SKIPPED, 0, 0);
+			return;
+		}
+	}
+	
+#if defined(FEATURE_LED_FRAMES_ENABLED)
+	if (streaming) {
+		if (!streamShowPending && !force)
+			return;
+		
+		// the buffer keeps the frame, so the next one only needs the leds that changed
+		streamShowPending = false;
+		led_strip_write(&streamSegment, 1);
+		return;
+	}
+#endif
+	
+	// writing the strip keeps interrupts disabled for a long time, so only do it when a color changed.
+	// configuration changes force a write, which also covers mappings that got disabled.
+	bool changed = force;
+	
+	for (uint8_t m = 0; m < MAX_LED_MAPPINGS; ++m)
+	{
+        const LedMapping* mapping = &LIGHT_CONF.ledMappings[m];
+        const LightRule* rule = Lights_MappingRule(mapping);
+
+        if (rule == NULL)
+            continue;
+		
+		rgb_color color = Lights_MappingColor(mapping, rule);
 		
-		for (uint8_t led = mapping->ledIndexBegin; led < mapping->ledIndexEnd; ++led) {
-            LED_COLORS[led] = color;
+		if (memcmp(&color, &mappingColors[m], sizeof (rgb_color)) != 0) {
+			mappingColors[m] = color;
+			changed = true;
 		}
 	}
 	
-	if(update || force) {
-		led_strip_write(LED_COLORS, LED_COUNT);
+	if (!changed) {
+		return;
 	}
+	
+	led_strip_write(ledSegments, ledSegmentCount);
 }
 
 
 #else
-void Lights_UpdateConfiguration(const LightConfiguration* lightConfiguration) { ; }
+void Lights_UpdateConfiguration(void) { ; }
+void Lights_UpdateThresholds(void) { ; }
 void Lights_Update(bool force) { ; }
+void Lights_SetFrameRate(uint16_t framesPerSecond) { ; }
+void Lights_Task(void) { ; }
+void Lights_WriteFrame(uint8_t flags, uint8_t ledIndex, uint8_t ledCount, const rgb_color* colors) { ; }
 #endif
\ No newline at end of file
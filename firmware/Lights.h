@@ -20,6 +20,12 @@ enum LightRuleFlags
     LRF_FADE_OFF = 0x4,
 };
 
+enum LedFrameFlags
+{
+    LFF_SHOW = 0x1, // show the streamed frame on the next lights frame
+    LFF_STOP = 0x2, // stop streaming and go back to the light rules
+};
+
 typedef struct
 {
     uint8_t flags;
@@ -46,9 +52,24 @@ typedef struct
     uint8_t selectedLedMappingIndex;
 } __attribute__((packed)) LightConfiguration;
 
-void Lights_UpdateConfiguration(const LightConfiguration* lightConfiguration);
+void Lights_UpdateConfiguration(void);
+
+// Returns the light rule the mapping shows, NULL if the mapping or its rule is disabled.
+const LightRule* Lights_MappingRule(const LedMapping* mapping);
+
+// Precomputes what the fades need from the sensor thresholds. Pad_UpdateConfiguration calls it.
+void Lights_UpdateThresholds(void);
 void Lights_Update(bool force);
 
-extern LightConfiguration LIGHT_CONF;
+// Sets how many times per second Lights_Task renders a frame. Zero stops the lights.
+void Lights_SetFrameRate(uint16_t framesPerSecond);
+
+// Renders a frame when the frame timer elapsed, call it from the main loop.
+void Lights_Task(void);
+
+// Writes a run of colors into the frame streamed by the host, which replaces the light rules
+// until LFF_STOP is received or no frame arrived for a second. Runs are collected in a back buffer
+// and shown together on the next lights frame after a run with LFF_SHOW.
+void Lights_WriteFrame(uint8_t flags, uint8_t ledIndex, uint8_t ledCount, const rgb_color* colors);
 
 #endif
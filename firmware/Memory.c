@@ -0,0 +1,38 @@
+#include <stdint.h>
+#include <avr/io.h>
+
+#include "Memory.h"
+
+// end of .bss from the linker script. the heap would start here, but nothing uses malloc.
+extern uint8_t __heap_start;
+
+#define STACK_PAINT 0xC5
+
+// fills the ram above the static variables before main is called. the stack overwrites the paint
+// as it grows, so the lowest overwritten byte is as deep as it ever was. runs in .init3, where
+// the stack pointer is set up and nothing is on the stack yet.
+void Memory_PaintStack(void) __attribute__((naked, used, section(".init3")));
+
+void Memory_PaintStack(void) {
+    for (uint8_t* p = &__heap_start; p <= (uint8_t*) RAMEND; p++) {
+        *p = STACK_PAINT;
+    }
+}
+
+uint16_t Memory_StaticSize(void) {
+    return &__heap_start - (uint8_t*) RAMSTART;
+}
+
+uint16_t Memory_Free(void) {
+    return (uint8_t*) SP - &__heap_start;
+}
+
+uint16_t Memory_StackHighWater(void) {
+    const uint8_t* p = &__heap_start;
+
+    while (p <= (uint8_t*) RAMEND && *p == STACK_PAINT) {
+        p++;
+    }
+
+    return (uint8_t*) RAMEND + 1 - p;
+}
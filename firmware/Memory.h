@@ -0,0 +1,13 @@
+#ifndef _MEMORY_H_
+#define _MEMORY_H_
+    #include <stdint.h>
+
+    // Bytes of ram taken by static variables.
+    uint16_t Memory_StaticSize(void);
+
+    // Bytes between the static variables and the stack right now.
+    uint16_t Memory_Free(void);
+
+    // Most bytes the stack used since reset, including interrupts.
+    uint16_t Memory_StackHighWater(void);
+#endif
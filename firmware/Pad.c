@@ -9,11 +9,12 @@
 
 #define MIN(a,b) ((a) < (b) ? a : b)
 
-PadConfigurationV2 PAD_CONF;
-
 PadState PAD_STATE = { 
     .sensorValues = { [0 ... SENSOR_COUNT - 1] = 0 },
-    .buttonsPressed = { [0 ... BUTTON_COUNT - 1] = false }
+    .sensorMinimums = { [0 ... SENSOR_COUNT - 1] = 0 },
+    .sensorMaximums = { [0 ... SENSOR_COUNT - 1] = 0 },
+    .buttonsPressed = { [0 ... BUTTON_COUNT - 1] = false },
+    .scanTime = 0
 };
 
 typedef struct {
@@ -23,6 +24,44 @@ typedef struct {
 
 InternalPadConfiguration INTERNAL_PAD_CONF;
 
+// button edges are queued by Pad_UpdateState and drained by the host through a feature report.
+// both happen from the main loop, so no locking is needed.
+static ButtonEvent buttonEvents[BUTTON_EVENT_QUEUE_SIZE];
+static uint8_t buttonEventsHead = 0;
+static uint8_t buttonEventsTail = 0;
+static uint8_t buttonEventsDropped = 0;
+
+static void Pad_QueueButtonEvent(uint8_t button, bool pressed) {
+    if ((uint8_t)(buttonEventsHead - buttonEventsTail) == BUTTON_EVENT_QUEUE_SIZE) {
+        if (buttonEventsDropped < UINT8_MAX) {
+            buttonEventsDropped++;
+        }
+        return;
+    }
+
+    ButtonEvent* event = &buttonEvents[buttonEventsHead % BUTTON_EVENT_QUEUE_SIZE];
+    event->time = PAD_STATE.scanTime;
+    event->button = pressed ? button | BUTTON_EVENT_PRESSED : button;
+    buttonEventsHead++;
+}
+
+uint8_t Pad_ReadButtonEvents(ButtonEvent* events, uint8_t maxEvents, uint8_t* dropped) {
+    uint8_t count = 0;
+
+    while (count < maxEvents && buttonEventsTail != buttonEventsHead) {
+        events[count++] = buttonEvents[buttonEventsTail % BUTTON_EVENT_QUEUE_SIZE];
+        buttonEventsTail++;
+    }
+
+    *dropped = buttonEventsDropped;
+    buttonEventsDropped = 0;
+    return count;
+}
+
+bool Pad_ButtonEventsPending(void) {
+    return buttonEventsTail != buttonEventsHead || buttonEventsDropped > 0;
+}
+
 void Pad_UpdateInternalConfiguration(void) {
 	/*
     for (int i = 0; i < SENSOR_COUNT; i++) {
@@ -47,21 +86,71 @@ void Pad_UpdateInternalConfiguration(void) {
         // mark -1 to end
         INTERNAL_PAD_CONF.buttonToSensorMap[buttonIndex][mapIndex] = -1;
     }
+
+    Pad_UpdateScanList();
 }
 
-void Pad_Initialize(const PadConfigurationV2* padConfiguration) {
-    Pad_UpdateConfiguration(padConfiguration);
+// set by the configuring host for its whole session, see Pad_SetScanAllSensors
+static bool scanAllSensors = false;
+
+// Returns true if the sensor presses a button or drives a light.
+static bool Pad_IsSensorUsed(uint8_t sensor) {
+    int8_t button = PAD_CONF.sensors[sensor].buttonMapping;
+
+    if (button >= 0 && button < BUTTON_COUNT) {
+        return true;
+    }
+
+    #if defined(FEATURE_LIGHTS_ENABLED)
+        for (uint8_t m = 0; m < MAX_LED_MAPPINGS; m++) {
+            const LedMapping* mapping = &LIGHT_CONF.ledMappings[m];
+
+            if (mapping->sensorIndex == sensor && Lights_MappingRule(mapping) != NULL) {
+                return true;
+            }
+        }
+    #endif
+
+    return false;
+}
+
+void Pad_UpdateScanList(void) {
+    // Only scan sensors which are wired up, not disabled and used for something.
+    uint8_t scanList[SENSOR_COUNT];
+    uint8_t scanListLength = 0;
+
+    for (uint8_t sensorIndex = 0; sensorIndex < SENSOR_COUNT; sensorIndex++) {
+        if (ADC_IsSensorWired(sensorIndex)
+            && !(PAD_CONF.sensors[sensorIndex].flags & ADC_DISABLED)
+            && (scanAllSensors || Pad_IsSensorUsed(sensorIndex))) {
+            scanList[scanListLength++] = sensorIndex;
+        }
+    }
+
+    ADC_SetScanList(scanList, scanListLength);
+}
+
+void Pad_SetScanAllSensors(bool scanAll) {
+    scanAllSensors = scanAll;
+    Pad_UpdateScanList();
+}
+
+void Pad_Initialize(void) {
+    Pad_UpdateConfiguration();
 	ADC_Init();
 }
 
-void Pad_UpdateConfiguration(const PadConfigurationV2* padConfiguration) {
-    memcpy(&PAD_CONF, padConfiguration, sizeof (PadConfigurationV2));
+void Pad_UpdateConfiguration(void) {
     Pad_UpdateInternalConfiguration();
+
+    // the light fades depend on the sensor thresholds
+    Lights_UpdateThresholds();
 }
 
-void Pad_UpdateState(void) {
-    for (int i = 0; i < SENSOR_COUNT; i++) {
-        PAD_STATE.sensorValues[i] = ADC_Read(i);
+bool Pad_UpdateState(void) {
+    // the adc scans in the background, only evaluate when a new scan has completed
+    if (!ADC_ReadScan(PAD_STATE.sensorValues, PAD_STATE.sensorMinimums, PAD_STATE.sensorMaximums, &PAD_STATE.scanTime)) {
+        return false;
     }
 
     for (int i = 0; i < BUTTON_COUNT; i++) {
@@ -94,8 +183,12 @@ void Pad_UpdateState(void) {
             }
         }
 
+        if (PAD_STATE.buttonsPressed[i] != newButtonPressedState) {
+            Pad_QueueButtonEvent(i, newButtonPressedState);
+        }
+
         PAD_STATE.buttonsPressed[i] = newButtonPressedState;
     }
-	
-	Lights_Update(false);
+
+    return true;
 }
@@ -21,24 +21,59 @@ typedef struct {
 	uint16_t releaseThreshold;
 	int8_t buttonMapping;
 	uint8_t resistorValue;
-	uint16_t flags;
+	uint8_t flags;
+	uint8_t sampling;
 } __attribute__((packed)) SensorConfig;
 
+// SensorConfig.sampling, low nibble: the sensor is converted 1 << n times per scan and averaged.
+// high nibble: the sensor is only converted every 1 << n scans, and keeps its last value in between.
+#define SAMPLING_OVERSAMPLING_MASK 0x0F
+#define MAX_OVERSAMPLING_SHIFT 4
+#define SAMPLING_RATE_DIVISOR_MASK 0xF0
+#define SAMPLING_RATE_DIVISOR_SHIFT 4
+#define MAX_RATE_DIVISOR_SHIFT 4
+
 typedef struct {
     SensorConfig sensors[SENSOR_COUNT];
 	uint8_t selectedSensorIndex;
 } __attribute__((packed)) PadConfigurationV2;
 
 typedef struct {
-    uint16_t sensorValues[SENSOR_COUNT];
+    uint16_t sensorValues[SENSOR_COUNT]; // mean of the conversions in the last scan
+    uint16_t sensorMinimums[SENSOR_COUNT]; // lowest conversion in the last scan
+    uint16_t sensorMaximums[SENSOR_COUNT]; // highest conversion in the last scan
     bool buttonsPressed[BUTTON_COUNT];
+    uint32_t scanTime; // Timer_Micros when the scan of sensorValues completed
 } PadState;
 
-void Pad_Initialize(const PadConfigurationV2* padConfiguration);
-void Pad_UpdateState(void);
-void Pad_UpdateConfiguration(const PadConfigurationV2* padConfiguration);
+// set on the button index of a ButtonEvent when the button was pressed, clear when it was released
+#define BUTTON_EVENT_PRESSED 0x80
+
+// must be a power of two
+#define BUTTON_EVENT_QUEUE_SIZE 16
+
+typedef struct {
+    uint32_t time; // scanTime of the scan the edge was detected in
+    uint8_t button;
+} __attribute__((packed)) ButtonEvent;
+
+void Pad_Initialize(void);
+bool Pad_UpdateState(void);
+void Pad_UpdateConfiguration(void);
+
+// Rebuilds the list of scanned sensors. Sensors that neither press a button nor drive a light
+// are not scanned, and read as zero. Lights_UpdateConfiguration calls it for led mapping changes.
+void Pad_UpdateScanList(void);
+
+// Scans the unused sensors as well, so a configuring host can show them while they are being mapped.
+// It stays set until the host clears it or the pad is configured by the next host.
+void Pad_SetScanAllSensors(bool scanAll);
+
+// Removes up to maxEvents of the oldest queued button events and returns how many were copied.
+// dropped is set to the number of events lost to a full queue since the previous call.
+uint8_t Pad_ReadButtonEvents(ButtonEvent* events, uint8_t maxEvents, uint8_t* dropped);
+bool Pad_ButtonEventsPending(void);
 
-extern PadConfigurationV2 PAD_CONF;
 extern PadState PAD_STATE;
 
 #endif
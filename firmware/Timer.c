@@ -0,0 +1,46 @@
+#include <stdint.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <util/atomic.h>
+
+#include "Timer.h"
+
+// timer1 runs freely with prescaler 8, so it ticks 1 << TIMER_TICK_SHIFT times per microsecond
+#if F_CPU == 16000000
+    #define TIMER_TICK_SHIFT 1
+#elif F_CPU == 8000000
+    #define TIMER_TICK_SHIFT 0
+#else
+    #error "Timer: unsupported F_CPU"
+#endif
+
+// counts timer1 overflows, which extends the 16 bit counter
+static volatile uint32_t timerOverflows = 0;
+
+void Timer_Init(void) {
+    TCCR1A = 0;
+    TCCR1B = (1 << CS11);
+    TCNT1 = 0;
+    TIMSK1 = (1 << TOIE1);
+}
+
+ISR(TIMER1_OVF_vect) {
+    timerOverflows++;
+}
+
+uint32_t Timer_Micros(void) {
+    uint32_t overflows;
+    uint16_t ticks;
+
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        ticks = TCNT1;
+        overflows = timerOverflows;
+
+        // the counter may have wrapped after interrupts were disabled, without the overflow being counted yet
+        if ((TIFR1 & (1 << TOV1)) && ticks < 0x8000) {
+            overflows++;
+        }
+    }
+
+    return (overflows << (16 - TIMER_TICK_SHIFT)) | (ticks >> TIMER_TICK_SHIFT);
+}
@@ -0,0 +1,9 @@
+#ifndef _TIMER_H_
+#define _TIMER_H_
+    #include <stdint.h>
+
+    void Timer_Init(void);
+
+    // Microseconds since Timer_Init, wrapping at 2^32. Safe to call from interrupts.
+    uint32_t Timer_Micros(void);
+#endif